@@ -68,6 +68,10 @@ static void __interrupt __far (*OldInt8)(void);
 static volatile int32_t taskServiceRate  = MAX_SERVICE_RATE;
 static volatile int32_t taskServiceCount = 0;
 
+#if defined PROFILING
+static volatile uint32_t taskServiceTime = 0;
+#endif
+
 static boolean isTS_Installed = false;
 
 
@@ -86,7 +90,12 @@ static void TS_SetClockSpeed(int32_t speed)
 	else
 		taskServiceRate = MAX_SERVICE_RATE;
 
+#if defined PROFILING
+	// rate generator, the count goes down by one per clock
+	outp(0x43, 0x34);
+#else
 	outp(0x43, 0x36);
+#endif
 	outp(0x40, LOBYTE(taskServiceRate));
 	outp(0x40, HIBYTE(taskServiceRate));
 
@@ -117,6 +126,10 @@ static void __interrupt __far TS_ServiceSchedule (void)
 		}
 	}
 
+#if defined PROFILING
+	taskServiceTime += taskServiceRate;
+#endif
+
 	taskServiceCount += taskServiceRate;
 	if (taskServiceCount > 0xffffL)
 	{
@@ -251,3 +264,33 @@ void TS_Terminate(int16_t priority)
 
 	_enable();
 }
+
+
+#if defined PROFILING
+/*---------------------------------------------------------------------
+   Function: TS_GetTime
+
+   Returns the number of 8253 clocks since the task service started.
+---------------------------------------------------------------------*/
+
+uint32_t TS_GetTime(void)
+{
+	_disable();
+
+	// latch the count of channel 0
+	outp(0x43, 0x00);
+	uint16_t count = inp(0x40);
+	count |= inp(0x40) << 8;
+
+	uint32_t time = taskServiceTime;
+
+	// the count has wrapped around, but the interrupt hasn't been serviced yet
+	outp(0x20, 0x0a);
+	if ((inp(0x20) & 1) && count > taskServiceRate / 2)
+		time += taskServiceRate;
+
+	_enable();
+
+	return time + (taskServiceRate - count);
+}
+#endif
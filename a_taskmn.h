@@ -36,4 +36,8 @@ void TS_Shutdown(void);
 void TS_ScheduleTask(void (*function)(void), int16_t rate, int16_t priority);
 void TS_Terminate(int16_t priority);
 
+#if defined PROFILING
+uint32_t TS_GetTime(void);
+#endif
+
 #endif
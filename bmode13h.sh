@@ -4,7 +4,8 @@ unset CFLAGS
 
 #export RENDER_OPTIONS="-DONE_WALL_TEXTURE -DFLAT_WALL -DFLAT_SPAN -DFLAT_SKY -DDISABLE_STATUS_BAR"
 #export RENDER_OPTIONS="-DFLAT_SPAN -DVIEWWINDOWWIDTH=240 -DHIGH_DETAIL"
-export RENDER_OPTIONS="-DFLAT_SPAN -DVIEWWINDOWWIDTH=240"
+#export RENDER_OPTIONS="-DFLAT_SPAN -DVIEWWINDOWWIDTH=240 -DVARIABLE_DETAIL"
+export RENDER_OPTIONS="-DFLAT_SPAN -DVIEWWINDOWWIDTH=240 $3"
 
 export CPU=$1
 export OUTPUT=$2
@@ -10,6 +10,10 @@
 ./bmda.sh     i286  D286MDA.EXE
 ./bmode13h.sh i8088 D8M13H.EXE
 ./bmode13h.sh i286  D2M13H.EXE
+./bmode13h.sh i8088 D8M13HP.EXE -DPRECOMPOSED_TEXTURES
+./bmode13h.sh i286  D2M13HP.EXE -DPRECOMPOSED_TEXTURES
+./bmode13h.sh i8088 D8M13HV.EXE -DVARIABLE_DETAIL
+./bmode13h.sh i286  D2M13HV.EXE -DVARIABLE_DETAIL
 ./bmode13m.sh i8088 D8M13M.EXE
 ./bmode13m.sh i286  D2M13M.EXE
 ./bmode13l.sh i8088 D8M13L.EXE
@@ -182,6 +182,12 @@
 	#define ZONEIDCHECK 1
 #endif
 
+/* Define this to check for lumps that are still pinned at the end of a frame */
+
+#ifdef DEBUG
+	#define PINCHECK 1
+#endif
+
 /* Define to empty if `const' does not conform to ANSI C. */
 /* #undef const */
 
@@ -53,6 +53,7 @@
 #include "m_menu.h"
 #include "i_system.h"
 #include "i_sound.h"
+#include "i_video.h"
 #include "g_game.h"
 #include "hu_stuff.h"
 #include "wi_stuff.h"
@@ -96,6 +97,53 @@ int16_t _g_fps_framerate;
 static int16_t titlepicnum;
 
 
+#if defined VARIABLE_DETAIL
+//
+// Adaptive detail
+// Every ADAPTFRAMES frames the time they took is compared to the frame budget.
+// The detail is lowered when they took longer
+// and raised when they took less than half of it.
+// Only consecutive frames that rendered the view count,
+// a restored view or the fullscreen automap starts over.
+//
+
+#define ADAPTFRAMES 8
+
+static int16_t framebudget; // in tics per ADAPTFRAMES frames, 0 keeps the detail level
+static int16_t adaptframes;
+
+static void D_AdaptDetail(boolean rendered)
+{
+    static int32_t starttime;
+
+    if (!rendered)
+    {
+        adaptframes = 0;
+        return;
+    }
+
+    int32_t now = I_GetTime();
+
+    if (adaptframes == 0)
+        starttime = now;
+    else if (adaptframes == ADAPTFRAMES)
+    {
+        int16_t tics = now - starttime;
+
+        if (tics > framebudget && detailshift < 2)
+            R_SetDetail(detailshift + 1);
+        else if (tics < framebudget / 2 && detailshift > 0)
+            R_SetDetail(detailshift - 1);
+
+        starttime = now;
+        adaptframes = 0;
+    }
+
+    adaptframes++;
+}
+#endif
+
+
 /*
  * D_PostEvent - Event handling
  *
@@ -146,6 +194,7 @@ gamestate_t wipegamestate = GS_DEMOSCREEN; // wipegamestate can be set to -1 to
 static void D_Display (void)
 {
     static gamestate_t oldgamestate = GS_LEVEL;
+    static boolean viewsaved = false;
 
     if (nodrawers)                    // for comparative timing / profiling
         return;
@@ -160,6 +209,10 @@ static void D_Display (void)
         if (oldgamestate == GS_LEVEL)
             I_SetPalette(0); // cph - use default (basic) palette
 
+#if defined VARIABLE_DETAIL
+        adaptframes = 0;
+#endif
+
         switch (_g_gamestate)
         {
             case GS_INTERMISSION:
@@ -180,10 +233,37 @@ static void D_Display (void)
 
         // Work out if the player view is visible, and if there is a border
         boolean viewactive = (!(automapmode & am_active) || (automapmode & am_overlay));
+        boolean rendered   = false;
 
         // Now do the drawing
         if (viewactive)
-            R_RenderPlayerView (&_g_player);
+        {
+            // Show the previous frame again if nothing in it has changed
+            if (R_IsViewUnchanged(&_g_player))
+            {
+                if (!viewsaved || !I_RestoreViewWindow())
+                {
+                    R_RenderPlayerView (&_g_player);
+                    viewsaved = I_SaveViewWindow();
+                    rendered  = true;
+                }
+            }
+            else
+            {
+                R_RenderPlayerView (&_g_player);
+                viewsaved = false;
+                rendered  = true;
+            }
+        }
+
+#if defined VARIABLE_DETAIL
+        if (framebudget)
+            D_AdaptDetail(rendered);
+#else
+        UNUSED(rendered);
+#endif
+
+        I_ProfileStage(PROF_HUD);
 
         if (automapmode & am_active)
             AM_Drawer();
@@ -192,6 +272,8 @@ static void D_Display (void)
         ST_Drawer();
 
         HU_Drawer();
+
+        I_ProfileStage(PROF_OTHER);
     }
 
     oldgamestate = wipegamestate = _g_gamestate;
@@ -205,8 +287,14 @@ static void D_Display (void)
         // wipe update
         D_Wipe();
     else
+    {
         // normal update
+        I_ProfileStage(PROF_FINISHUPDATE);
         I_FinishUpdate ();              // page flip or blit buffer
+        I_ProfileStage(PROF_OTHER);
+    }
+
+    I_ProfileEndFrame();
 }
 
 
@@ -243,6 +331,8 @@ static void TryRunTics (void)
 
         M_Ticker ();
         G_Ticker ();
+        Z_Ticker ();
+        Z_UpdateStats();
         _g_gametic++;
     }
 }
@@ -275,6 +365,8 @@ _Noreturn static void D_DoomLoop(void)
 
             M_Ticker ();
             G_Ticker ();
+            Z_Ticker ();
+            Z_UpdateStats();
 
             _g_gametic++;
             maketic++;
@@ -459,6 +551,7 @@ static void D_DoomMainSetup(void)
 
     printf("Z_Init: Init zone memory allocation daemon.\n");
     Z_Init();
+    Z_InitStats();
 
     G_ReloadDefaults();    // killough 3/4/98: set defaults just loaded.
 
@@ -506,6 +599,26 @@ static void D_DoomMainSetup(void)
     {
         D_StartTitle();                 // start up intro loop
     }
+
+#if defined VARIABLE_DETAIL
+    // 0 = high, 1 = medium, 2 = low detail
+    p = M_CheckParm("-detail");
+    if (p && p < myargc - 1)
+    {
+        int16_t shift = atoi(myargv[p + 1]);
+        if (0 <= shift && shift <= 2)
+            R_SetDetail(shift);
+    }
+
+    // adapt the detail level to reach a frame rate
+    p = M_CheckParm("-autodetail");
+    if (p && p < myargc - 1)
+    {
+        int16_t fps = atoi(myargv[p + 1]);
+        if (fps > 0)
+            framebudget = ADAPTFRAMES * TICRATE / fps;
+    }
+#endif
 }
 
 //
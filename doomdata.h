@@ -138,5 +138,19 @@ typedef struct {
 typedef char assertMapnodeSize[sizeof(mapnode_t) == 28 ? 1 : -1];
 
 
+// Potentially visible set, made by tools/mappvs.c
+typedef struct {
+  int16_t numsubsectors;
+  int16_t numnodes;
+} mappvs_t;
+
+// Followed by:
+//  uint16_t offsets of the rows from the start of the lump [numsubsectors]
+//  byte     rows of one bit per subsector,
+//           a zero byte is followed by the number of zero bytes in the run
+
+typedef char assertMappvsSize[sizeof(mappvs_t) == 4 ? 1 : -1];
+
+
 
 #endif // __DOOMDATA__
@@ -488,6 +488,7 @@ void G_Ticker (void)
 
     case GS_INTERMISSION:
         WI_Ticker ();
+        P_PrefetchTicker ();
         break;
 
     case GS_FINALE:
@@ -655,6 +656,10 @@ static void G_DoCompleted (void)
     }
 
     WI_Start (&_g_wminfo);
+
+    // after E1M8 the game is over
+    if (_g_gamemap != 8)
+        P_StartPrefetch(_g_wminfo.next + 1);
 }
 
 //
@@ -1075,6 +1080,7 @@ static void G_DoPlayDemo(void)
     _g_demoplayback = true;
 
     starttime = I_GetTime();
+    I_ProfileReset();
 }
 
 /* G_CheckDemoStatus
@@ -1089,9 +1095,23 @@ void G_CheckDemoStatus (void)
         // killough -- added fps information and made it work for longer demos:
         uint32_t realtics = endtime - starttime;
         uint32_t resultfps = TICRATE * 1000L * _g_gametic / realtics;
-        I_Error ("Timed %lu gametics in %lu realtics = %lu.%.3lu frames per second",
+        uint32_t hits, misses;
+        R_GetColumnCacheStats(&hits, &misses);
+#if defined PROFILING
+        I_Error ("Timed %lu gametics in %lu realtics = %lu.%.3lu frames per second\n"
+                 "Column cache: %lu hits, %lu misses\n"
+                 "%s",
+                 (uint32_t) _g_gametic,realtics,
+                 resultfps / 1000, resultfps % 1000,
+                 hits, misses,
+                 I_ProfileReport());
+#else
+        I_Error ("Timed %lu gametics in %lu realtics = %lu.%.3lu frames per second\n"
+                 "Column cache: %lu hits, %lu misses",
                  (uint32_t) _g_gametic,realtics,
-                 resultfps / 1000, resultfps % 1000);
+                 resultfps / 1000, resultfps % 1000,
+                 hits, misses);
+#endif
     }
 
     Z_ChangeTagToCache(demobuffer);
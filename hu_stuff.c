@@ -65,6 +65,7 @@ typedef struct
 // widgets
 static hu_textline_t  w_title;
 static hu_textline_t  w_message;
+static hu_textline_t  w_zonestats;
 
 // boolean stating whether to update window
 static boolean    message_on;
@@ -81,6 +82,8 @@ boolean    _g_message_dontfuckwithme;
 
 #define HU_MSGY         0
 
+#define HU_ZONESTATSY   (HU_MSGY + HU_FONT_HEIGHT + 1)
+
 
 static int16_t font_lump_offset;
 
@@ -96,8 +99,9 @@ void HU_Init(void)
 {
 	font_lump_offset = W_GetNumForName(HU_FONTSTART_LUMP) - HU_FONTSTART;
 
-	w_message.y = HU_MSGY;
-	w_title.y   = HU_TITLEY;
+	w_message.y   = HU_MSGY;
+	w_title.y     = HU_TITLEY;
+	w_zonestats.y = HU_ZONESTATSY;
 }
 
 
@@ -206,6 +210,15 @@ void HU_Drawer(void)
     {
         HUlib_drawTextLine(&w_message);
     }
+
+    // zone statistics from -zonestats
+    const char* zonestats = Z_GetStatsText();
+    if (zonestats)
+    {
+        w_zonestats.len = strlen(zonestats);
+        strcpy(w_zonestats.lineoftext, zonestats);
+        HUlib_drawTextLine(&w_zonestats);
+    }
 }
 
 
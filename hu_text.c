@@ -81,6 +81,8 @@ boolean    _g_message_dontfuckwithme;
 
 #define HU_MSGY         0
 
+#define HU_ZONESTATSY   (HU_MSGY + 1)
+
 
 //
 // HU_Init()
@@ -178,6 +180,11 @@ void HU_Drawer(void)
 
     if (message_on)
 		V_DrawString(0, HU_MSGY, D_LIGHT_RED, w_message.lineoftext);
+
+	// zone statistics from -zonestats
+	const char* zonestats = Z_GetStatsText();
+	if (zonestats)
+		V_DrawString(0, HU_ZONESTATSY, D_LIGHT_RED, zonestats);
 }
 
 
@@ -288,6 +288,83 @@ int32_t I_GetTime(void)
 }
 
 
+#if defined PROFILING
+//
+// Per stage frame timing, in 1193182 Hz clocks of the 8253
+//
+
+static const char* const profnames[NUMPROFSTAGES] =
+{
+	"other", "setup", "bsp", "walls", "planes", "masked", "hud", "update"
+};
+
+static profstage_t profstage;
+static uint32_t    proflast;
+static uint32_t    profframe[NUMPROFSTAGES];
+static uint32_t    proftotal[NUMPROFSTAGES];
+static uint32_t    profmax[NUMPROFSTAGES];
+static int32_t     profframes;
+
+
+void I_ProfileStage(profstage_t stage)
+{
+	uint32_t now = TS_GetTime();
+	profframe[profstage] += now - proflast;
+	proflast  = now;
+	profstage = stage;
+}
+
+
+void I_ProfileEndFrame(void)
+{
+	I_ProfileStage(profstage);
+
+	for (int16_t i = 0; i < NUMPROFSTAGES; i++)
+	{
+		proftotal[i] += profframe[i];
+		if (profmax[i] < profframe[i])
+			profmax[i] = profframe[i];
+
+		profframe[i] = 0;
+	}
+
+	profframes++;
+}
+
+
+void I_ProfileReset(void)
+{
+	for (int16_t i = 0; i < NUMPROFSTAGES; i++)
+	{
+		profframe[i] = 0;
+		proftotal[i] = 0;
+		profmax[i]   = 0;
+	}
+
+	profframes = 0;
+	profstage  = PROF_OTHER;
+	proflast   = TS_GetTime();
+}
+
+
+const char* I_ProfileReport(void)
+{
+	static char report[NUMPROFSTAGES * 48 + 64];
+
+	char* s = report;
+	s += sprintf(s, "%li frames\nstage    avg us   max us total ms\n", profframes);
+
+	for (int16_t i = 0; i < NUMPROFSTAGES; i++)
+	{
+		uint32_t avg = profframes ? proftotal[i] / profframes : 0;
+		s += sprintf(s, "%-6s %8lu %8lu %8lu\n", profnames[i], avg * 838 / 1000, profmax[i] * 838 / 1000, proftotal[i] / 1193);
+	}
+
+	return report;
+}
+#endif
+
+
 void I_InitTimer(void)
 {
 	TS_ScheduleTask(I_TimerISR, TICRATE, TIMER_PRIORITY);
@@ -41,6 +41,31 @@
 void I_InitTimer(void);
 int32_t I_GetTime(void);
 
+#if defined PROFILING
+typedef enum
+{
+	PROF_OTHER,
+	PROF_SETUPFRAME,
+	PROF_BSP,
+	PROF_WALLS,
+	PROF_PLANES,
+	PROF_MASKED,
+	PROF_HUD,
+	PROF_FINISHUPDATE,
+	NUMPROFSTAGES
+} profstage_t;
+
+// The time until the next call is charged to stage
+void I_ProfileStage(profstage_t stage);
+void I_ProfileEndFrame(void);
+void I_ProfileReset(void);
+const char* I_ProfileReport(void);
+#else
+#define I_ProfileStage(stage)
+#define I_ProfileEndFrame()
+#define I_ProfileReset()
+#endif
+
 _Noreturn void I_Quit(void);
 _Noreturn void I_Error(const char *error, ...);
 
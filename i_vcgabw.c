@@ -151,6 +151,31 @@ static void I_UploadNewPalette(int8_t pal)
 }
 
 
+//
+// The screen is uploaded in bands of 8 rows.
+// Only the bands that have been drawn in since the last upload are copied.
+//
+
+#define DIRTYBANDSHIFT	3
+#define DIRTYBANDHEIGHT	(1 << DIRTYBANDSHIFT)
+#define NUMDIRTYBANDS	(SCREENHEIGHT >> DIRTYBANDSHIFT)
+
+static uint8_t dirtybands[NUMDIRTYBANDS];
+
+
+static void I_MarkDirty(int16_t yl, int16_t yh)
+{
+	if (yl < 0)
+		yl = 0;
+
+	if (yh > SCREENHEIGHT - 1)
+		yh = SCREENHEIGHT - 1;
+
+	if (yl <= yh)
+		memset(&dirtybands[yl >> DIRTYBANDSHIFT], true, (yh >> DIRTYBANDSHIFT) - (yl >> DIRTYBANDSHIFT) + 1);
+}
+
+
 void I_InitGraphicsHardwareSpecificCode(void)
 {
 	__djgpp_nearptr_enable();
@@ -163,6 +188,7 @@ void I_InitGraphicsHardwareSpecificCode(void)
 
 	_s_screen = Z_MallocStatic(VIEWWINDOWWIDTH * SCREENHEIGHT);
 	_fmemset(_s_screen, 0, VIEWWINDOWWIDTH * SCREENHEIGHT);
+	I_MarkDirty(0, SCREENHEIGHT - 1);
 }
 
 
@@ -172,39 +198,34 @@ void I_ShutdownGraphics(void)
 }
 
 
-static boolean drawStatusBar = true;
-
-
 static void I_DrawBuffer(uint8_t __far* buffer)
 {
 	uint8_t __far* src = buffer;
 	uint8_t __far* dst = videomemory;
 
-	for (int16_t y = 0; y < (SCREENHEIGHT - ST_HEIGHT) / 2; y++)
+	for (int16_t b = 0; b < NUMDIRTYBANDS; b++)
 	{
-		_fmemcpy(dst, src, VIEWWINDOWWIDTH);
-		dst += 0x2000;
-		src += VIEWWINDOWWIDTH;
+		if (dirtybands[b])
+		{
+			dirtybands[b] = false;
 
-		_fmemcpy(dst, src, VIEWWINDOWWIDTH);
-		dst -= 0x2000 - PLANEWIDTH;
-		src += VIEWWINDOWWIDTH;
-	}
+			for (int16_t y = 0; y < DIRTYBANDHEIGHT / 2; y++)
+			{
+				_fmemcpy(dst, src, VIEWWINDOWWIDTH);
+				dst += 0x2000;
+				src += VIEWWINDOWWIDTH;
 
-	if (drawStatusBar)
-	{
-		for (int16_t y = 0; y < ST_HEIGHT / 2; y++)
+				_fmemcpy(dst, src, VIEWWINDOWWIDTH);
+				dst -= 0x2000 - PLANEWIDTH;
+				src += VIEWWINDOWWIDTH;
+			}
+		}
+		else
 		{
-			_fmemcpy(dst, src, VIEWWINDOWWIDTH);
-			dst += 0x2000;
-			src += VIEWWINDOWWIDTH;
-
-			_fmemcpy(dst, src, VIEWWINDOWWIDTH);
-			dst -= 0x2000 - PLANEWIDTH;
-			src += VIEWWINDOWWIDTH;
+			dst += PLANEWIDTH      * DIRTYBANDHEIGHT / 2;
+			src += VIEWWINDOWWIDTH * DIRTYBANDHEIGHT;
 		}
 	}
-	drawStatusBar = true;
 }
 
 
@@ -299,6 +320,8 @@ void R_DrawColumnSprite(const draw_column_vars_t *dcvars)
 	if (count <= 0)
 		return;
 
+	I_MarkDirty(dcvars->yl, dcvars->yh);
+
 	source = dcvars->source;
 
 	colormap = dcvars->colormap;
@@ -367,12 +390,26 @@ void R_DrawColumnFlat(uint8_t color, const draw_column_vars_t *dcvars)
 	if (count <= 0)
 		return;
 
+	I_MarkDirty(dcvars->yl, dcvars->yh);
+
 	dest = _s_screen + (dcvars->yl * VIEWWINDOWWIDTH) + dcvars->x;
 
 	R_DrawColumnFlat2(color, dcvars->yl, count);
 }
 
 
+void R_DrawSpanFlat(uint8_t color, int16_t y, int16_t x1, int16_t x2)
+{
+	I_MarkDirty(y, y);
+
+	// the dither pattern alternates per row
+	if (y & 1)
+		color = (color << 4) | (color >> 4);
+
+	_fmemset(_s_screen + (y * VIEWWINDOWWIDTH) + x1, color, x2 + 1 - x1);
+}
+
+
 #define FUZZCOLOR1 0x00
 #define FUZZCOLOR2 0x02
 #define FUZZCOLOR3 0x20
@@ -399,6 +436,8 @@ void R_DrawFuzzColumn(const draw_column_vars_t *dcvars)
 	if (count <= 0)
 		return;
 
+	I_MarkDirty(dcvars->yl, dcvars->yh);
+
 	uint8_t __far* dest = _s_screen + (dcvars->yl * VIEWWINDOWWIDTH) + dcvars->x;
 
 	static int16_t fuzzpos = 0;
@@ -418,6 +457,47 @@ void R_DrawFuzzColumn(const draw_column_vars_t *dcvars)
 void V_ClearViewWindow(void)
 {
 	_fmemset(_s_screen, 0, VIEWWINDOWWIDTH * (SCREENHEIGHT - ST_HEIGHT));
+	I_MarkDirty(0, SCREENHEIGHT - ST_HEIGHT - 1);
+}
+
+
+//
+// A copy of the view window in purgable memory
+//
+static uint8_t __far* viewwindowcopy;
+
+boolean I_SaveViewWindow(void)
+{
+	if (viewwindowcopy)
+		Z_ChangeTagToStatic(viewwindowcopy);
+	else if (Z_IsFreeBlockAvailable(VIEWWINDOWWIDTH * (SCREENHEIGHT - ST_HEIGHT)))
+		viewwindowcopy = Z_MallocStaticWithUser(VIEWWINDOWWIDTH * (SCREENHEIGHT - ST_HEIGHT), (void __far*__far*)&viewwindowcopy);
+	else
+		return false;
+
+	_fmemcpy(viewwindowcopy, _s_screen, VIEWWINDOWWIDTH * (SCREENHEIGHT - ST_HEIGHT));
+	Z_ChangeTagToCache(viewwindowcopy);
+	return true;
+}
+
+
+boolean I_RestoreViewWindow(void)
+{
+	if (!viewwindowcopy)
+		return false;
+
+	// only copy back, and upload, the bands that have been drawn over
+	for (int16_t b = 0; b < (SCREENHEIGHT - ST_HEIGHT) >> DIRTYBANDSHIFT; b++)
+	{
+		uint16_t offset = b * (VIEWWINDOWWIDTH * DIRTYBANDHEIGHT);
+		if (_fmemcmp(&_s_screen[offset], &viewwindowcopy[offset], VIEWWINDOWWIDTH * DIRTYBANDHEIGHT))
+		{
+			_fmemcpy(&_s_screen[offset], &viewwindowcopy[offset], VIEWWINDOWWIDTH * DIRTYBANDHEIGHT);
+			dirtybands[b] = true;
+		}
+	}
+
+	return true;
 }
 
 
@@ -435,6 +515,8 @@ void V_ShutdownDrawLine(void)
 
 void V_DrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color)
 {
+	I_MarkDirty(y0 < y1 ? y0 : y1, y0 < y1 ? y1 : y0);
+
 	UNUSED(color);
 
 	int16_t dx = abs(x1 - x0);
@@ -494,6 +576,8 @@ void V_DrawBackground(int16_t backgroundnum)
 	}
 
 	Z_ChangeTagToCache(src);
+
+	I_MarkDirty(0, SCREENHEIGHT - 1);
 }
 
 
@@ -503,9 +587,11 @@ void V_DrawRaw(int16_t num, uint16_t offset)
 
 	offset = (offset / SCREENWIDTH) * VIEWWINDOWWIDTH;
 
+	uint16_t lumpLength = W_LumpLength(num);
+	I_MarkDirty(offset / VIEWWINDOWWIDTH, (offset + lumpLength) / VIEWWINDOWWIDTH - 1);
+
 	if (lump != NULL)
 	{
-		uint16_t lumpLength = W_LumpLength(num);
 		_fmemcpy(&_s_screen[offset], lump, lumpLength);
 		Z_ChangeTagToCache(lump);
 	}
@@ -518,8 +604,6 @@ void ST_Drawer(void)
 {
 	if (ST_NeedUpdate())
 		ST_doRefresh();
-	else
-		drawStatusBar = false;
 }
 
 
@@ -531,6 +615,8 @@ void V_DrawPatchNotScaled(int16_t x, int16_t y, const patch_t __far* patch)
 	y -= patch->topoffset;
 	x -= patch->leftoffset;
 
+	I_MarkDirty(y, y + patch->height - 1);
+
 	byte __far* desttop = _s_screen + (y * VIEWWINDOWWIDTH) + (x >> 2);
 
 	int16_t width = patch->width;
@@ -622,6 +708,8 @@ void V_DrawPatchScaled(int16_t x, int16_t y, const patch_t __far* patch)
 	const int16_t right  = ((x + patch->width)  * DX) >> FRACBITS;
 	const int16_t bottom = ((y + patch->height) * DY) >> FRACBITS;
 
+	I_MarkDirty((y * DY) >> FRACBITS, bottom);
+
 	uint16_t   col = 0;
 
 	for (int16_t dc_x = left; dc_x < right; dc_x++, col += DXI)
@@ -736,6 +824,7 @@ static boolean wipe_ScreenWipe(int16_t ticks)
 		}
 	}
 
+	I_MarkDirty(0, SCREENHEIGHT - 1);
 	I_DrawBuffer(frontbuffer);
 
 	return done;
@@ -395,6 +395,14 @@ void R_DrawColumnFlat(uint8_t color, const draw_column_vars_t *dcvars)
 }
 
 
+void R_DrawSpanFlat(uint8_t color, int16_t y, int16_t x1, int16_t x2)
+{
+	// every byte written copies the latches
+	volatile uint8_t loadLatches = colors[color];
+	_fmemset(_s_screen + (y * PLANEWIDTH) + x1, 0, x2 + 1 - x1);
+}
+
+
 #define FUZZCOLOR1 0x00
 #define FUZZCOLOR2 0x08
 #define FUZZCOLOR3 0x80
@@ -504,6 +512,8 @@ void V_DrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color)
 
 
 static int16_t cachedLumpNum;
+static int16_t cachedLumpHeight;
+static boolean viewwindowsaved;
 
 
 static void V_Blit(int16_t num, uint16_t offset, int16_t height)
@@ -568,6 +578,8 @@ void V_DrawBackground(int16_t backgroundnum)
 		Z_ChangeTagToCache(lump);
 
 		cachedLumpNum = backgroundnum;
+		cachedLumpHeight = SCREENHEIGHT;
+		viewwindowsaved = false;
 
 		// set write mode 1
 		outp(GC_INDEX, GC_MODE);
@@ -580,8 +592,6 @@ void V_DrawBackground(int16_t backgroundnum)
 
 void V_DrawRaw(int16_t num, uint16_t offset)
 {
-	static int16_t cachedLumpHeight;
-
 	if (cachedLumpNum != num)
 	{
 		const uint8_t __far* lump = W_TryGetLumpByNum(num);
@@ -632,6 +642,7 @@ void V_DrawRaw(int16_t num, uint16_t offset)
 
 			Z_ChangeTagToCache(lump);
 			cachedLumpNum = num;
+			viewwindowsaved = false;
 
 			// set write mode 1
 			outp(GC_INDEX, GC_MODE);
@@ -643,6 +654,46 @@ void V_DrawRaw(int16_t num, uint16_t offset)
 }
 
 
+//
+// The view window is saved in the fourth page,
+// below the cached status bar
+//
+static void I_CopyViewWindow(const uint8_t __far* src, uint8_t __far* dest)
+{
+	for (int16_t y = 0; y < SCREENHEIGHT - ST_HEIGHT; y++)
+	{
+		for (int16_t x = 0; x < VIEWWINDOWWIDTH; x++)
+		{
+			volatile uint8_t loadLatches = *src++;
+			*dest++ = 0;
+		}
+		src  += PLANEWIDTH - VIEWWINDOWWIDTH;
+		dest += PLANEWIDTH - VIEWWINDOWWIDTH;
+	}
+}
+
+
+boolean I_SaveViewWindow(void)
+{
+	// the view window overwrites the lower part of a cached background or raw lump
+	if (cachedLumpHeight > ST_HEIGHT)
+		cachedLumpNum = -1;
+
+	I_CopyViewWindow(_s_screen, D_MK_FP(PAGE3 + (256 >> 4), ST_HEIGHT * PLANEWIDTH + __djgpp_conventional_base));
+	viewwindowsaved = true;
+	return true;
+}
+
+
+boolean I_RestoreViewWindow(void)
+{
+	if (viewwindowsaved)
+		I_CopyViewWindow(D_MK_FP(PAGE3 + (256 >> 4), ST_HEIGHT * PLANEWIDTH + __djgpp_conventional_base), _s_screen);
+
+	return viewwindowsaved;
+}
+
+
 void ST_Drawer(void)
 {
 	if (ST_NeedUpdate())
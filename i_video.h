@@ -34,6 +34,8 @@ void I_ShutdownGraphics(void);
 void I_ReloadPalette(void);
 void I_SetPalette(int8_t pal);
 void I_FinishUpdate(void);
+boolean I_SaveViewWindow(void);
+boolean I_RestoreViewWindow(void);
 
 
 void R_DrawColumnSprite(const draw_column_vars_t *dcvars);
@@ -260,6 +260,16 @@ void R_DrawColumnFlat(uint8_t color, const draw_column_vars_t *dcvars)
 }
 
 
+void R_DrawSpanFlat(uint8_t color, int16_t y, int16_t x1, int16_t x2)
+{
+	uint16_t __far* d = (uint16_t __far*)(_s_screen + (y * PLANEWIDTH) + x1 * 2);
+	uint16_t c = 0x0700 | color;
+
+	for (int16_t x = x1; x <= x2; x++)
+		*d++ = c;
+}
+
+
 #define FUZZCOLOR1 0x00
 #define FUZZCOLOR2 0xb0
 #define FUZZCOLOR3 0x00
@@ -310,6 +320,19 @@ void V_ClearViewWindow(void)
 }
 
 
+// The view window is always redrawn
+boolean I_SaveViewWindow(void)
+{
+	return false;
+}
+
+
+boolean I_RestoreViewWindow(void)
+{
+	return false;
+}
+
+
 void V_InitDrawLine(void)
 {
 	// Do nothing
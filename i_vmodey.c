@@ -437,6 +437,49 @@ void R_DrawColumnFlat(uint8_t color, const draw_column_vars_t *dcvars)
 }
 
 
+void R_DrawSpanFlat(uint8_t color, int16_t y, int16_t x1, int16_t x2)
+{
+#if VIEWWINDOWWIDTH == 60
+	_fmemset(_s_screen + (y * PLANEWIDTH) + x1, color, x2 + 1 - x1);
+#else
+#if VIEWWINDOWWIDTH == 120
+	uint8_t __far* d = _s_screen + (y * PLANEWIDTH) + x1 / 2;
+	int16_t count = x2 / 2 - x1 / 2;
+	uint8_t leftmask  = (15 << (2 * (x1 & 1))) & 15;
+	uint8_t rightmask = 15 >> (2 * (1 - (x2 & 1)));
+#elif VIEWWINDOWWIDTH == 240
+	uint8_t __far* d = _s_screen + (y * PLANEWIDTH) + x1 / 4;
+	int16_t count = x2 / 4 - x1 / 4;
+	uint8_t leftmask  = (15 << (x1 & 3)) & 15;
+	uint8_t rightmask = 15 >> (3 - (x2 & 3));
+#else
+#error unsupported VIEWWINDOWWIDTH value
+#endif
+
+	if (count == 0)
+	{
+		outp(SC_INDEX + 1, leftmask & rightmask);
+		*d = color;
+		return;
+	}
+
+	// partial bytes at both ends, all four planes in between
+	outp(SC_INDEX + 1, leftmask);
+	*d++ = color;
+
+	if (count > 1)
+	{
+		outp(SC_INDEX + 1, 15);
+		_fmemset(d, color, count - 1);
+		d += count - 1;
+	}
+
+	outp(SC_INDEX + 1, rightmask);
+	*d = color;
+#endif
+}
+
+
 #define FUZZOFF (PLANEWIDTH)
 #define FUZZTABLE 50
 
@@ -569,6 +612,8 @@ void V_DrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color)
 
 
 static int16_t cachedLumpNum;
+static int16_t cachedLumpHeight;
+static boolean viewwindowsaved;
 
 
 static void V_Blit(int16_t num, uint16_t offset, int16_t height)
@@ -625,6 +670,8 @@ void V_DrawBackground(int16_t backgroundnum)
 		Z_ChangeTagToCache(lump);
 
 		cachedLumpNum = backgroundnum;
+		cachedLumpHeight = SCREENHEIGHT;
+		viewwindowsaved = false;
 	}
 
 	V_Blit(backgroundnum, 0, SCREENHEIGHT);
@@ -633,8 +680,6 @@ void V_DrawBackground(int16_t backgroundnum)
 
 void V_DrawRaw(int16_t num, uint16_t offset)
 {
-	static int16_t cachedLumpHeight;
-
 	if (cachedLumpNum != num)
 	{
 		const uint8_t __far* lump = W_TryGetLumpByNum(num);
@@ -661,6 +706,7 @@ void V_DrawRaw(int16_t num, uint16_t offset)
 			Z_ChangeTagToCache(lump);
 
 			cachedLumpNum = num;
+			viewwindowsaved = false;
 		}
 	}
 
@@ -668,6 +714,55 @@ void V_DrawRaw(int16_t num, uint16_t offset)
 }
 
 
+//
+// The view window is saved in the fourth page,
+// below the cached status bar
+//
+static void I_CopyViewWindow(const uint8_t __far* src, uint8_t __far* dest)
+{
+#if VIEWWINDOWWIDTH != 60
+	outp(SC_INDEX + 1, 15);
+#endif
+
+	// set write mode 1
+	outp(GC_INDEX, GC_MODE);
+	outp(GC_INDEX + 1, inp(GC_INDEX + 1) | 1);
+
+	for (int16_t y = 0; y < SCREENHEIGHT - ST_HEIGHT; y++)
+	{
+		for (int16_t x = 0; x < SCREENWIDTH / 4; x++)
+		{
+			volatile uint8_t loadLatches = src[y * PLANEWIDTH + x];
+			dest[y * PLANEWIDTH + x] = 0;
+		}
+	}
+
+	// set write mode 0
+	outp(GC_INDEX + 1, inp(GC_INDEX + 1) & ~1);
+}
+
+
+boolean I_SaveViewWindow(void)
+{
+	// the view window overwrites the lower part of a cached background or raw lump
+	if (cachedLumpHeight > ST_HEIGHT)
+		cachedLumpNum = -1;
+
+	I_CopyViewWindow(_s_screen, D_MK_FP(PAGE3, ST_HEIGHT * PLANEWIDTH + __djgpp_conventional_base));
+	viewwindowsaved = true;
+	return true;
+}
+
+
+boolean I_RestoreViewWindow(void)
+{
+	if (viewwindowsaved)
+		I_CopyViewWindow(D_MK_FP(PAGE3, ST_HEIGHT * PLANEWIDTH + __djgpp_conventional_base), _s_screen);
+
+	return viewwindowsaved;
+}
+
+
 void ST_Drawer(void)
 {
 	if (ST_NeedUpdate())
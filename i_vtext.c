@@ -504,6 +504,16 @@ void R_DrawColumnFlat(uint8_t color, const draw_column_vars_t *dcvars)
 }
 
 
+void R_DrawSpanFlat(uint8_t color, int16_t y, int16_t x1, int16_t x2)
+{
+	uint8_t __far* d = _s_screen + (y * PLANEWIDTH) + (x1 << 1);
+
+	// only the attributes
+	for (int16_t x = x1; x <= x2; x++, d += 2)
+		*d = color;
+}
+
+
 #define FUZZCOLOR1 0x00
 #define FUZZCOLOR2 0x08
 #define FUZZCOLOR3 0x80
@@ -553,6 +563,19 @@ void V_ClearViewWindow(void)
 }
 
 
+// The view window is always redrawn
+boolean I_SaveViewWindow(void)
+{
+	return false;
+}
+
+
+boolean I_RestoreViewWindow(void)
+{
+	return false;
+}
+
+
 void V_InitDrawLine(void)
 {
 	// Do nothing
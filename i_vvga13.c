@@ -119,6 +119,31 @@ static void I_UploadNewPalette(int8_t pal)
 }
 
 
+//
+// The screen is uploaded in bands of 8 rows.
+// Only the bands that have been drawn in since the last upload are copied.
+//
+
+#define DIRTYBANDSHIFT	3
+#define DIRTYBANDHEIGHT	(1 << DIRTYBANDSHIFT)
+#define NUMDIRTYBANDS	(SCREENHEIGHT >> DIRTYBANDSHIFT)
+
+static uint8_t dirtybands[NUMDIRTYBANDS];
+
+
+static void I_MarkDirty(int16_t yl, int16_t yh)
+{
+	if (yl < 0)
+		yl = 0;
+
+	if (yh > SCREENHEIGHT - 1)
+		yh = SCREENHEIGHT - 1;
+
+	if (yl <= yh)
+		memset(&dirtybands[yl >> DIRTYBANDSHIFT], true, (yh >> DIRTYBANDSHIFT) - (yl >> DIRTYBANDSHIFT) + 1);
+}
+
+
 void I_InitGraphicsHardwareSpecificCode(void)
 {
 	I_SetScreenMode(0x13);
@@ -130,34 +155,34 @@ void I_InitGraphicsHardwareSpecificCode(void)
 
 	_s_screen = Z_MallocStatic(SCREENWIDTH * SCREENHEIGHT);
 	_fmemset(_s_screen, 0, SCREENWIDTH * SCREENHEIGHT);
+	I_MarkDirty(0, SCREENHEIGHT - 1);
 }
 
 
-static boolean drawStatusBar = true;
-
-
 static void I_DrawBuffer(void)
 {
 	uint8_t __far* src = _s_screen;
 	uint8_t __far* dst = vgascreen;
 
-	for (uint_fast8_t y = 0; y < SCREENHEIGHT - ST_HEIGHT; y++)
+	for (int16_t b = 0; b < NUMDIRTYBANDS; b++)
 	{
-		_fmemcpy(dst, src, SCREENWIDTH);
-		dst += SCREENWIDTH_VGA;
-		src += SCREENWIDTH;
-	}
+		if (dirtybands[b])
+		{
+			dirtybands[b] = false;
 
-	if (drawStatusBar)
-	{
-		for (uint_fast8_t y = 0; y < ST_HEIGHT; y++)
+			for (uint_fast8_t y = 0; y < DIRTYBANDHEIGHT; y++)
+			{
+				_fmemcpy(dst, src, SCREENWIDTH);
+				dst += SCREENWIDTH_VGA;
+				src += SCREENWIDTH;
+			}
+		}
+		else
 		{
-			_fmemcpy(dst, src, SCREENWIDTH);
-			dst += SCREENWIDTH_VGA;
-			src += SCREENWIDTH;
+			dst += SCREENWIDTH_VGA * DIRTYBANDHEIGHT;
+			src += SCREENWIDTH     * DIRTYBANDHEIGHT;
 		}
 	}
-	drawStatusBar = true;
 }
 
 
@@ -237,6 +262,59 @@ inline static void R_DrawColumnPixel(uint8_t __far* dest, const byte __far* sour
 }
 
 
+#if defined VARIABLE_DETAIL
+#if VIEWWINDOWWIDTH != 240
+#error VARIABLE_DETAIL needs a VIEWWINDOWWIDTH of 240
+#endif
+
+// The screen x of view column x
+#define COLUMNX(x) ((x) << detailshift)
+
+// Medium and low detail draw the columns two and four pixels wide
+inline static void R_DrawColumnPixelWide(uint8_t __far* dest, const byte __far* source, uint16_t frac, int16_t shift)
+{
+	uint16_t color = colormap[source[frac>>COLBITS]];
+	color = (color | (color << 8));
+
+	uint16_t __far* d = (uint16_t __far*) dest;
+	*d = color;
+	if (shift == 2)
+		d[1] = color;
+}
+
+
+static void R_DrawColumnWide(uint16_t fracstep, uint16_t frac, int16_t count)
+{
+	if (detailshift == 1)
+	{
+		do
+		{
+			R_DrawColumnPixelWide(dest, source, frac, 1); dest += SCREENWIDTH; frac += fracstep;
+		} while (--count);
+	}
+	else
+	{
+		do
+		{
+			R_DrawColumnPixelWide(dest, source, frac, 2); dest += SCREENWIDTH; frac += fracstep;
+		} while (--count);
+	}
+}
+
+
+static void R_DrawColumnFlatWide(uint8_t col, int16_t count)
+{
+	do
+	{
+		_fmemset(dest, col, 1 << detailshift);
+		dest += SCREENWIDTH;
+	} while (--count);
+}
+#else
+#define COLUMNX(x) ((x) * 4 * 60 / VIEWWINDOWWIDTH)
+#endif
+
+
 #if defined C_ONLY
 static void R_DrawColumn2(uint16_t fracstep, uint16_t frac, int16_t count)
 {
@@ -296,11 +374,13 @@ void R_DrawColumnSprite(const draw_column_vars_t *dcvars)
 	if (count <= 0)
 		return;
 
+	I_MarkDirty(dcvars->yl, dcvars->yh);
+
 	source = dcvars->source;
 
 	colormap = dcvars->colormap;
 
-	dest = _s_screen + (dcvars->yl * SCREENWIDTH) + (dcvars->x * 4 * 60 / VIEWWINDOWWIDTH);
+	dest = _s_screen + (dcvars->yl * SCREENWIDTH) + COLUMNX(dcvars->x);
 
 	const uint16_t fracstep = dcvars->fracstep;
 	uint16_t frac = (dcvars->texturemid >> COLEXTRABITS) + (dcvars->yl - CENTERY) * fracstep;
@@ -309,6 +389,11 @@ void R_DrawColumnSprite(const draw_column_vars_t *dcvars)
 	//  e.g. a DDA-lile scaling.
 	// This is as fast as it gets.
 
+#if defined VARIABLE_DETAIL
+	if (detailshift)
+		R_DrawColumnWide(fracstep, frac, count);
+	else
+#endif
 	R_DrawColumn2(fracstep, frac, count);
 }
 
@@ -386,12 +471,29 @@ void R_DrawColumnFlat(uint8_t col, const draw_column_vars_t *dcvars)
 	if (count <= 0)
 		return;
 
-	dest = _s_screen + (dcvars->yl * SCREENWIDTH) + (dcvars->x * 4 * 60 / VIEWWINDOWWIDTH);
+	I_MarkDirty(dcvars->yl, dcvars->yh);
 
+	dest = _s_screen + (dcvars->yl * SCREENWIDTH) + COLUMNX(dcvars->x);
+
+#if defined VARIABLE_DETAIL
+	if (detailshift)
+		R_DrawColumnFlatWide(col, count);
+	else
+#endif
 	R_DrawColumnFlat2(col, col, count);
 }
 
 
+void R_DrawSpanFlat(uint8_t col, int16_t y, int16_t x1, int16_t x2)
+{
+	I_MarkDirty(y, y);
+
+	uint8_t __far* d = _s_screen + (y * SCREENWIDTH) + COLUMNX(x1);
+
+	_fmemset(d, col, COLUMNX(x2 + 1 - x1));
+}
+
+
 #define FUZZOFF 120 /* SCREENWIDTH / 2 so it fits in an int8_t */
 #define FUZZTABLE 50
 
@@ -433,14 +535,21 @@ void R_DrawFuzzColumn(const draw_column_vars_t *dcvars)
 	if (count <= 0)
 		return;
 
+	I_MarkDirty(dc_yl, dc_yh);
+
 	colormap = &fullcolormap[6 * 256];
 
-	uint8_t __far* dest = _s_screen + (dc_yl * SCREENWIDTH) + (dcvars->x * 4 * 60 / VIEWWINDOWWIDTH);
+	uint8_t __far* dest = _s_screen + (dc_yl * SCREENWIDTH) + COLUMNX(dcvars->x);
 
 	static int16_t fuzzpos = 0;
 
 	do
 	{
+#if defined VARIABLE_DETAIL
+		if (detailshift)
+			R_DrawColumnPixelWide(dest, &dest[fuzzoffset[fuzzpos] * 2], 0, detailshift);
+		else
+#endif
 		R_DrawColumnPixel(dest, &dest[fuzzoffset[fuzzpos] * 2], 0);
 		dest += SCREENWIDTH;
 
@@ -466,6 +575,8 @@ inline static void R_DrawSpanPixel(uint32_t __far* dest, const byte __far* sourc
 
 void R_DrawSpan(uint16_t y, uint16_t x1, uint16_t x2, const draw_span_vars_t *dsvars)
 {
+	I_MarkDirty(y, y);
+
 	uint16_t count = (x2 - x1);
 
 	const byte __far* source   = dsvars->source;
@@ -529,6 +640,47 @@ void R_DrawSpan(uint16_t y, uint16_t x1, uint16_t x2, const draw_span_vars_t *ds
 void V_ClearViewWindow(void)
 {
 	_fmemset(_s_screen, 0, SCREENWIDTH * (SCREENHEIGHT - ST_HEIGHT));
+	I_MarkDirty(0, SCREENHEIGHT - ST_HEIGHT - 1);
+}
+
+
+//
+// A copy of the view window in purgable memory
+//
+static uint8_t __far* viewwindowcopy;
+
+boolean I_SaveViewWindow(void)
+{
+	if (viewwindowcopy)
+		Z_ChangeTagToStatic(viewwindowcopy);
+	else if (Z_IsFreeBlockAvailable(SCREENWIDTH * (SCREENHEIGHT - ST_HEIGHT)))
+		viewwindowcopy = Z_MallocStaticWithUser(SCREENWIDTH * (SCREENHEIGHT - ST_HEIGHT), (void __far*__far*)&viewwindowcopy);
+	else
+		return false;
+
+	_fmemcpy(viewwindowcopy, _s_screen, SCREENWIDTH * (SCREENHEIGHT - ST_HEIGHT));
+	Z_ChangeTagToCache(viewwindowcopy);
+	return true;
+}
+
+
+boolean I_RestoreViewWindow(void)
+{
+	if (!viewwindowcopy)
+		return false;
+
+	// only copy back, and upload, the bands that have been drawn over
+	for (int16_t b = 0; b < (SCREENHEIGHT - ST_HEIGHT) >> DIRTYBANDSHIFT; b++)
+	{
+		uint16_t offset = b * (SCREENWIDTH * DIRTYBANDHEIGHT);
+		if (_fmemcmp(&_s_screen[offset], &viewwindowcopy[offset], SCREENWIDTH * DIRTYBANDHEIGHT))
+		{
+			_fmemcpy(&_s_screen[offset], &viewwindowcopy[offset], SCREENWIDTH * DIRTYBANDHEIGHT);
+			dirtybands[b] = true;
+		}
+	}
+
+	return true;
 }
 
 
@@ -555,6 +707,8 @@ void V_ShutdownDrawLine(void)
 //
 void V_DrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color)
 {
+	I_MarkDirty(y0 < y1 ? y0 : y1, y0 < y1 ? y1 : y0);
+
 	int16_t dx = abs(x1 - x0);
 	int16_t sx = x0 < x1 ? 1 : -1;
 
@@ -615,6 +769,8 @@ void V_DrawBackground(int16_t backgroundnum)
 	}
 
 	Z_ChangeTagToCache(src);
+
+	I_MarkDirty(0, SCREENHEIGHT - 1);
 }
 
 
@@ -622,9 +778,11 @@ void V_DrawRaw(int16_t num, uint16_t offset)
 {
 	const uint8_t __far* lump = W_TryGetLumpByNum(num);
 
+	uint16_t lumpLength = W_LumpLength(num);
+	I_MarkDirty(offset / SCREENWIDTH, (offset + lumpLength) / SCREENWIDTH - 1);
+
 	if (lump != NULL)
 	{
-		uint16_t lumpLength = W_LumpLength(num);
 		_fmemcpy(&_s_screen[offset], lump, lumpLength);
 		Z_ChangeTagToCache(lump);
 	}
@@ -637,8 +795,6 @@ void ST_Drawer(void)
 {
 	if (ST_NeedUpdate())
 		ST_doRefresh();
-	else
-		drawStatusBar = false;
 }
 
 
@@ -647,6 +803,8 @@ void V_DrawPatchNotScaled(int16_t x, int16_t y, const patch_t __far* patch)
 	y -= patch->topoffset;
 	x -= patch->leftoffset;
 
+	I_MarkDirty(y, y + patch->height - 1);
+
 	byte __far* desttop = _s_screen + (y * SCREENWIDTH) + x;
 
 	int16_t width = patch->width;
@@ -729,6 +887,8 @@ void V_DrawPatchScaled(int16_t x, int16_t y, const patch_t __far* patch)
 	const int16_t right  = ((x + patch->width)  * DX) >> FRACBITS;
 	const int16_t bottom = ((y + patch->height) * DY) >> FRACBITS;
 
+	I_MarkDirty((y * DY) >> FRACBITS, bottom);
+
 	uint16_t   col = 0;
 
 	for (int16_t dc_x = left; dc_x < right; dc_x++, col += DXI)
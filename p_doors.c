@@ -83,6 +83,7 @@ static void EV_LightTurnOnPartway(const line_t __far* line, fixed_t level)
 
       sector->lightlevel =   // Set level in-between extremes
   (level * bright + (FRACUNIT-level) * min) >> FRACBITS;
+      R_InvalidateSector(sector);
     }
 }
 
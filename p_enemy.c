@@ -300,6 +300,7 @@ void A_FaceTarget(mobj_t __far* actor)
   if (!actor->target)
     return;
   actor->flags &= ~MF_AMBUSH;
+  angle_t oldangle = actor->angle;
   actor->angle = R_PointToAngle2(actor->x, actor->y,
                                  actor->target->x, actor->target->y);
   if (actor->target->flags & MF_SHADOW)
@@ -307,6 +308,10 @@ void A_FaceTarget(mobj_t __far* actor)
       int32_t t = P_Random();
       actor->angle += (t-P_Random())<<21;
     }
+
+  // a different angle can show a different rotation
+  if (actor->angle != oldangle)
+    R_InvalidateMobj(actor);
 }
 
 //
@@ -31,6 +31,7 @@
 #include "p_enemy.h"
 #include "p_inter.h"
 #include "p_map.h"
+#include "r_main.h"
 
 #include "globdata.h"
 
@@ -276,6 +277,9 @@ void A_Chase(mobj_t __far* actor)
             actor->angle -= ANG90/2;
         else if (delta < 0)
             actor->angle += ANG90/2;
+
+        if (delta)
+            R_InvalidateMobj(actor);
     }
 
     if (!actor->target || !(actor->target->flags&MF_SHOOTABLE))
@@ -65,6 +65,8 @@ static boolean P_ThingHeightClip(mobj_t __far* thing)
 {
   boolean   onfloor;
 
+  R_InvalidateMobj(thing);
+
   onfloor = (thing->z == thing->floorz);
 
   P_CheckPosition (thing, thing->x, thing->y);
@@ -222,6 +224,8 @@ result_e T_MovePlaneFloor(sector_t __far* sector, fixed_t speed, fixed_t dest, i
   fixed_t       destheight; //jff 02/04/98 used to keep floors/ceilings
                             // from moving thru each other
 
+      R_InvalidateSector(sector);
+
       switch(direction)
       {
         case -1:
@@ -295,6 +299,8 @@ result_e T_MovePlaneCeiling(sector_t __far* sector, fixed_t speed, fixed_t dest,
   fixed_t       destheight; //jff 02/04/98 used to keep floors/ceilings
                             // from moving thru each other
 
+      R_InvalidateSector(sector);
+
       switch(direction)
       {
         case -1:
@@ -402,6 +408,7 @@ static void T_MoveFloor(floormove_t __far* floor)
         case donutRaise:
           floor->sector->special  = 0;
           floor->sector->floorpic = floor->texture;
+          R_InvalidateSector(floor->sector);
           break;
         default:
           break;
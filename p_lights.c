@@ -73,6 +73,8 @@ static void T_LightFlash (lightflash_t __far* flash)
   if (--flash->count)
     return;
 
+  R_InvalidateSector(flash->sector);
+
   if (flash->sector->lightlevel == flash->maxlight)
   {
     flash->sector->lightlevel = flash->minlight;
@@ -110,6 +112,8 @@ static void T_StrobeFlash (strobe_t __far*   flash)
   if (--flash->count)
     return;
 
+  R_InvalidateSector(flash->sector);
+
   if (flash->sector->lightlevel == flash->minlight)
   {
     flash-> sector->lightlevel = flash->maxlight;
@@ -142,6 +146,8 @@ typedef struct
 
 static void T_Glow(glow_t __far* g)
 {
+  R_InvalidateSector(g->sector);
+
   switch(g->direction)
   {
     case -1:
@@ -328,5 +334,6 @@ void EV_LightTurnOn(const line_t __far* line, int16_t bright)
 					tbright = temp->lightlevel;
 
 		sector->lightlevel = tbright;
+		R_InvalidateSector(sector);
 	}
 }
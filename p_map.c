@@ -1190,11 +1190,12 @@ void P_RadiusAttack(mobj_t __far* spot, mobj_t __far* source, int16_t damage)
 
 #include "z_bmallo.h"
 
-static struct block_memory_alloc_s secnodezone = { NULL, sizeof(msecnode_t) };
+static struct block_memory_alloc_s secnodezone = { NULL, sizeof(msecnode_t), NULL };
 
 void P_SetSecnodeFirstpoolToNull(void)
 {
 	secnodezone.firstpool = NULL;
+	secnodezone.emptypool = NULL;
 }
 
 
@@ -283,6 +283,8 @@ void P_UnsetThingPosition(mobj_t __far* thing)
 {
   if (!(thing->flags & MF_NOSECTOR))
     {
+      R_InvalidateSector(thing->subsector->sector);
+
       /* invisible things don't need to be in sector list
        * unlink from subsector
        *
@@ -346,6 +348,8 @@ void P_SetThingPosition(mobj_t __far* thing)
     {
       // invisible things don't go into the sector links
 
+      R_InvalidateSector(ss->sector);
+
       // killough 8/11/98: simpler scheme using pointer-to-pointer prev
       // pointers, allows head nodes to be treated like everything else
 
@@ -77,6 +77,10 @@ boolean P_SetMobjState(mobj_t __far* mobj, statenum_t state)
         st = &states[state];
         mobj->state = st;
         mobj->tics = st->tics;
+
+        if (mobj->sprite != st->sprite || mobj->frame != st->frame)
+            R_InvalidateMobj(mobj);
+
         mobj->sprite = st->sprite;
         mobj->frame = st->frame;
 
@@ -728,6 +732,8 @@ void P_MobjThinker (mobj_t __far* mobj)
 
     if (mobj->z != mobj->floorz || mobj->momz)
     {
+        R_InvalidateMobj(mobj);
+
         P_ZMovement(mobj);
         if (mobj->thinker.function != P_MobjThinker) // cph - Must've been removed
             return;       // killough - mobj was removed
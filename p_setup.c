@@ -156,7 +156,7 @@ static void P_LoadSubsectors (int16_t lump)
   uint16_t firstseg;    // Index of first one; segs are stored sequentially.
 
   numsubsectors = W_LumpLength (lump) / sizeof(mapsubsector_t);
-  _g_subsectors = Z_CallocLevel(numsubsectors * sizeof(subsector_t));
+  _g_subsectors = Z_CallocArena(numsubsectors * sizeof(subsector_t));
   data = W_GetLumpByNum(lump);
 
   firstseg = 0;
@@ -218,7 +218,7 @@ static void P_LoadSectors (int16_t lump)
   int16_t  i;
 
   _g_numsectors = W_LumpLength (lump) / sizeof(mapsector_t);
-  _g_sectors = Z_CallocLevel(_g_numsectors * sizeof(sector_t));
+  _g_sectors = Z_CallocArena(_g_numsectors * sizeof(sector_t));
   data = W_GetLumpByNum(lump);
 
   for (i=0; i<_g_numsectors; i++)
@@ -263,7 +263,7 @@ static void P_LoadNodes (int16_t lump)
 static void P_LoadThings(int16_t lump)
 {
 	_g_thingPoolSize = W_LumpLength(lump) / sizeof(mapthing_t);
-	_g_thingPool     = Z_CallocLevel(_g_thingPoolSize * sizeof(mobj_t));
+	_g_thingPool     = Z_CallocArena(_g_thingPoolSize * sizeof(mobj_t));
 
 	for (int16_t i = 0; i < _g_thingPoolSize; i++)
 		_g_thingPool[i].type = MT_NOTHING;
@@ -311,7 +311,7 @@ typedef char assertLineSize[sizeof(packed_line_t) == 15 ? 1 : -1];
 static void P_LoadLineDefs (int16_t lump)
 {
 	_g_numlines = W_LumpLength(lump) / sizeof(packed_line_t);
-	_g_lines    = Z_MallocLevel(_g_numlines * sizeof(line_t), NULL);
+	_g_lines    = Z_MallocArena(_g_numlines * sizeof(line_t));
 
 	const packed_line_t __far* lines = W_GetLumpByNum(lump);
 
@@ -371,7 +371,7 @@ typedef char assertMapsidedefSize[sizeof(mapsidedef_t) == 7 ? 1 : -1];
 static void P_LoadSideDefs (int16_t lump)
 {
   numsides = W_LumpLength(lump) / sizeof(mapsidedef_t);
-  _g_sides = Z_CallocLevel(numsides * sizeof(side_t));
+  _g_sides = Z_CallocArena(numsides * sizeof(side_t));
 
     const mapsidedef_t __far* data = W_GetLumpByNum(lump);
 
@@ -415,11 +415,13 @@ static void P_LoadBlockMap (int16_t lump)
     _g_bmapwidth  = _g_blockmaplump[2];
     _g_bmapheight = _g_blockmaplump[3];
 
+    _g_blockmap = _g_blockmaplump+4;
+}
 
+static void P_LoadBlockLinks(void)
+{
     // clear out mobj chains - CPhipps - use calloc
-    _g_blocklinks = Z_CallocLevel(_g_bmapwidth * _g_bmapheight * sizeof(*_g_blocklinks));
-
-    _g_blockmap = _g_blockmaplump+4;
+    _g_blocklinks = Z_CallocArena(_g_bmapwidth * _g_bmapheight * sizeof(*_g_blocklinks));
 }
 
 //
@@ -501,7 +503,7 @@ static void P_GroupLines (void)
     }
 
     {  // allocate line tables for each sector
-        const line_t __far*__far*linebuffer = Z_MallocLevel(total*sizeof(line_t __far*), NULL);
+        const line_t __far*__far*linebuffer = Z_MallocArena(total*sizeof(line_t __far*));
 
         for (i=0, sector = _g_sectors; i<_g_numsectors; i++, sector++)
         {
@@ -536,6 +538,133 @@ static void P_GroupLines (void)
 }
 
 
+//
+// P_LoadTopology
+// Loads what P_GroupLines computes from a lump
+// that has been prebaked by tools/maptopo.c.
+// Returns false if there's no such lump,
+// or if it doesn't belong to the loaded map.
+//
+
+typedef struct {
+  int16_t numsubsectors;
+  int16_t numsectors;
+  int16_t numlines;
+  int16_t totallines;
+} maptopology_t;
+
+// Followed by:
+//  int16_t     subsector sector numbers, -1 if none [numsubsectors]
+//  int16_t     sector line counts                   [numsectors]
+//  degenmobj_t sector sound origins                 [numsectors]
+//  int16_t     sector line numbers                  [totallines]
+
+typedef char assertMaptopologySize[sizeof(maptopology_t) == 8 ? 1 : -1];
+
+static boolean P_LoadTopology(int16_t map)
+{
+    char lumpname[9];
+    sprintf(lumpname, "E1M%dTOP", map);
+
+    int16_t lump = W_CheckNumForName(lumpname);
+    if (lump == -1)
+        return false;
+
+    const maptopology_t __far* data = W_GetLumpByNum(lump);
+
+    if (data->numsubsectors != numsubsectors
+     || data->numsectors    != _g_numsectors
+     || data->numlines      != _g_numlines
+     || W_LumpLength(lump)  != sizeof(maptopology_t) + (numsubsectors + _g_numsectors + data->totallines) * sizeof(int16_t) + _g_numsectors * sizeof(degenmobj_t))
+    {
+        Z_Free(data);
+        return false;
+    }
+
+    const int16_t     __far* subsectorsectors = (const int16_t __far*)(data + 1);
+    const int16_t     __far* linecounts       = subsectorsectors + numsubsectors;
+    const degenmobj_t __far* soundorgs        = (const degenmobj_t __far*)(linecounts + _g_numsectors);
+    const int16_t     __far* linenums         = (const int16_t __far*)(soundorgs + _g_numsectors);
+
+    for (int16_t i = 0; i < numsubsectors; i++)
+        _g_subsectors[i].sector = subsectorsectors[i] == -1 ? NULL : &_g_sectors[subsectorsectors[i]];
+
+    const line_t __far*__far*linebuffer = Z_MallocArena(data->totallines * sizeof(line_t __far*));
+
+    for (int16_t i = 0; i < _g_numsectors; i++)
+    {
+        sector_t __far* sector = &_g_sectors[i];
+
+        sector->lines     = linebuffer;
+        sector->linecount = linecounts[i];
+        sector->soundorg  = soundorgs[i];
+
+        for (int16_t l = 0; l < sector->linecount; l++)
+            *linebuffer++ = &_g_lines[*linenums++];
+    }
+
+    Z_Free(data);
+    return true;
+}
+
+
+//
+// P_LoadPVS
+// Loads the potentially visible set
+// that has been made by tools/mappvs.c.
+// Without it, or without enough memory for it,
+// every subsector is potentially visible.
+//
+
+static void P_LoadPVS(int16_t map)
+{
+    char lumpname[9];
+    sprintf(lumpname, "E1M%dPVS", map);
+
+    const mappvs_t __far* data = NULL;
+
+    int16_t lump = W_CheckNumForName(lumpname);
+    if (lump != -1 && Z_IsEnoughFreeMemory(W_LumpLength(lump) + (numsubsectors + 7) / 8 + (numnodes + 7) / 8))
+    {
+        data = W_GetLumpByNumAutoFree(lump);
+
+        if (data->numsubsectors != numsubsectors
+         || data->numnodes      != numnodes)
+        {
+            Z_Free(data);
+            data = NULL;
+        }
+    }
+
+    R_InitPVS(data);
+}
+
+
+//
+// P_InitLevelArena
+// Allocates one block for the level data of the map.
+// The line buffer size is an upper bound,
+// Z_TrimLevelArena gives back what's left over.
+//
+
+#define P_ArenaSize(size) (((uint32_t)(size) + 15) & ~15)
+
+static void P_InitLevelArena(int16_t lumpnum)
+{
+    uint16_t numlines = W_LumpLength(lumpnum + ML_LINEDEFS) / sizeof(packed_line_t);
+
+    uint32_t size = P_ArenaSize(W_LumpLength(lumpnum + ML_THINGS)   / sizeof(mapthing_t)     * sizeof(mobj_t))
+                  + P_ArenaSize(numlines * sizeof(line_t))
+                  + P_ArenaSize(_g_bmapwidth * _g_bmapheight * sizeof(*_g_blocklinks))
+                  + P_ArenaSize(W_LumpLength(lumpnum + ML_SECTORS)  / sizeof(mapsector_t)    * sizeof(sector_t))
+                  + P_ArenaSize(W_LumpLength(lumpnum + ML_SIDEDEFS) / sizeof(mapsidedef_t)   * sizeof(side_t))
+                  + P_ArenaSize(W_LumpLength(lumpnum + ML_SSECTORS) / sizeof(mapsubsector_t) * sizeof(subsector_t))
+                  + P_ArenaSize(2 * numlines * sizeof(line_t __far*));
+
+    Z_InitLevelArena(size);
+}
+
+
 static void P_FreeLevelData()
 {
 #if !defined FLAT_SPAN
@@ -545,6 +674,91 @@ static void P_FreeLevelData()
     Z_FreeTags();
 }
 
+//
+// P_PrefetchTicker
+// Prefetches the next map during the intermission,
+// one lump per tic, first the map lumps then the wall patches.
+//
+
+static int16_t prefetchmap;
+static int16_t prefetchlump = -1; // label of the map, -1 if there's nothing to prefetch
+static int16_t prefetchstep;
+static int16_t prefetchside;
+static uint8_t prefetchedtextures[256 / 8];
+
+void P_StartPrefetch(int16_t map)
+{
+    char lumpname[9];
+    sprintf(lumpname, "E1M%d", map);
+
+    prefetchmap  = map;
+    prefetchlump = W_GetNumForName(lumpname);
+    prefetchstep = ML_THINGS;
+    prefetchside = 0;
+    memset(prefetchedtextures, 0, sizeof(prefetchedtextures));
+}
+
+
+void P_PrefetchTicker(void)
+{
+    if (prefetchlump == -1)
+        return;
+
+    if (prefetchstep <= ML_BLOCKMAP)
+    {
+        W_PrefetchLumpByNum(prefetchlump + prefetchstep);
+        prefetchstep++;
+        return;
+    }
+
+    if (prefetchstep == ML_BLOCKMAP + 1)
+    {
+        char lumpname[9];
+        sprintf(lumpname, "E1M%dTOP", prefetchmap);
+
+        int16_t lump = W_CheckNumForName(lumpname);
+        if (lump != -1)
+            W_PrefetchLumpByNum(lump);
+
+        prefetchstep++;
+        return;
+    }
+
+#if !defined FLAT_WALL
+    // the textures of the sidedefs that haven't been thrown out
+    if (W_IsLumpCached(prefetchlump + ML_SIDEDEFS))
+    {
+        int16_t numsidedefs = W_LumpLength(prefetchlump + ML_SIDEDEFS) / sizeof(mapsidedef_t);
+        const mapsidedef_t __far* data = W_GetLumpByNum(prefetchlump + ML_SIDEDEFS);
+        boolean read = false;
+
+        for (; prefetchside < numsidedefs && !read; prefetchside++)
+        {
+            const int8_t texturenums[3] = {data[prefetchside].toptexture, data[prefetchside].midtexture, data[prefetchside].bottomtexture};
+
+            for (int16_t t = 0; t < 3; t++)
+            {
+                uint8_t texture = texturenums[t];
+                if (!(prefetchedtextures[texture / 8] & (1 << (texture % 8))))
+                {
+                    prefetchedtextures[texture / 8] |= 1 << (texture % 8);
+                    if (R_PrefetchTexture(texture))
+                        read = true;
+                }
+            }
+        }
+
+        Z_ChangeTagToCache(data);
+
+        if (prefetchside < numsidedefs)
+            return;
+    }
+#endif
+
+    prefetchlump = -1;
+}
+
+
 //
 // P_SetupLevel
 //
@@ -564,6 +778,8 @@ void P_SetupLevel(int16_t map)
     // Initial height of PointOfView will be set by player think.
     _g_player.viewz = 1;
 
+    prefetchlump = -1;
+
     // Make sure all sounds are stopped before Z_FreeTags.
     S_Start();
 
@@ -579,17 +795,24 @@ void P_SetupLevel(int16_t map)
 
     lumpnum = W_GetNumForName(lumpname);
 
+    P_LoadBlockMap  (lumpnum + ML_BLOCKMAP);
+    P_InitLevelArena(lumpnum);
     P_LoadThings    (lumpnum + ML_THINGS);
     P_LoadLineDefs  (lumpnum + ML_LINEDEFS);
     P_LoadSegs      (lumpnum + ML_SEGS);
-    P_LoadBlockMap  (lumpnum + ML_BLOCKMAP);
+    P_LoadBlockLinks();
     P_LoadNodes     (lumpnum + ML_NODES);
     P_LoadSectors   (lumpnum + ML_SECTORS);
     P_LoadSideDefs  (lumpnum + ML_SIDEDEFS);
     P_LoadReject    (lumpnum + ML_REJECT);
     P_LoadSubsectors(lumpnum + ML_SSECTORS);
 
-    P_GroupLines();
+    if (!P_LoadTopology(map))
+        P_GroupLines();
+
+    Z_TrimLevelArena();
+
+    P_LoadPVS(map);
 
     // Note: you don't need to clear player queue slots
     // a much simpler fix is in g_game.c
@@ -602,6 +825,8 @@ void P_SetupLevel(int16_t map)
     // set up world state
     P_SpawnSpecials();
 
+    R_InvalidateView();
+
     P_MapEnd();
 }
 
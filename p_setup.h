@@ -40,6 +40,8 @@
 
 
 void P_SetupLevel(int16_t map);
+void P_StartPrefetch(int16_t map);
+void P_PrefetchTicker(void);
 void P_Init(void);               /* Called by startup code. */
 
 #endif
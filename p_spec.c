@@ -65,7 +65,7 @@
 //
 // Animating textures and planes
 //
-static int16_t  animated_texture_basepic;
+int16_t  animated_texture_basepic;
 
 //
 // P_InitPicAnims
@@ -292,6 +292,9 @@ static void P_UpdateAnimatedTexture(void)
 void P_UpdateSpecials (void)
 {
     // Animate flats and textures globally
+    if ((_g_leveltime & 7) == 0)
+        R_InvalidateAnimation();
+
     P_UpdateAnimatedFlat();
     P_UpdateAnimatedTexture();
 
@@ -322,6 +325,8 @@ void P_UpdateSpecials (void)
                         break;
                 }
 
+                R_InvalidateSector(LN_FRONTSECTOR(_g_buttonlist[i].line));
+
                 S_StartSound2(_g_buttonlist[i].soundorg, sfx_swtchn);
                 memset(&_g_buttonlist[i],0,sizeof(button_t));
             }
@@ -423,12 +428,14 @@ void P_SpawnSpecials (void)
 typedef struct {
 	thinker_t thinker;				// Thinker structure for scrolling
 	int16_t __far* textureoffset;	// Affected textureoffset
+	sector_t __far* sector;			// Sector of the affected sidedef
 } scroll_t;
 
 
 static void T_Scroll(scroll_t __far* s)
 {
 	(*s->textureoffset)++;
+	R_InvalidateSector(s->sector);
 }
 
 
@@ -445,6 +452,7 @@ static void Add_Scroller(int16_t affectee)
 	scroll_t __far* s = Z_CallocLevSpec(sizeof *s);
 	s->thinker.function = T_Scroll;
 	s->textureoffset = &_g_sides[affectee].textureoffset;
+	s->sector        = _g_sides[affectee].sector;
 	P_AddThinker(&s->thinker);
 }
 
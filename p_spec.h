@@ -299,6 +299,8 @@ boolean EV_DoPlat(const line_t __far* line, plattype_e type);
 // at game start
 void P_InitPicAnims(void);
 
+extern int16_t animated_texture_basepic;
+
 void P_InitSwitchList
 ( void );
 
@@ -233,6 +233,8 @@ void P_ChangeSwitchTexture(line_t __far* line, boolean useAgain)
             break;
     }
 
+    R_InvalidateSector(LN_FRONTSECTOR(line));
+
     S_StartSound2(&LN_FRONTSECTOR(line)->soundorg, sfx_swtchn);
 
     if (useAgain)
@@ -182,6 +182,11 @@ static void R_LoadTexture(int16_t texture_num)
             break;
     }
 
+#if defined PRECOMPOSED_TEXTURES
+    if (texture->overlapped)
+        I_Error("R_LoadTexture: Texture %d has overlapping patches, run texmerge", texture_num);
+#endif
+
     textureheight[texture_num] = texture->height;
 
     texturetranslation[texture_num] = texture_num;
@@ -208,6 +213,64 @@ const texture_t __far* R_GetTexture(int16_t texture)
     return textures[texture];
 }
 
+//
+// R_TryGetLumpWithoutPurging
+// Like W_TryGetLumpByNum, but only reads the lump into free memory,
+// so prefetching never throws out cached lumps.
+//
+
+static const void __far* R_TryGetLumpWithoutPurging(int16_t num)
+{
+    if (!W_IsLumpCached(num) && !Z_IsFreeBlockAvailable(W_LumpLength(num)))
+        return NULL;
+
+    return W_TryGetLumpByNum(num);
+}
+
+
+//
+// R_PrefetchTexture
+// Prefetches the patches of a texture.
+// Returns true if a patch had to be read.
+//
+
+boolean R_PrefetchTexture(int16_t texture_num)
+{
+#if defined ONE_WALL_TEXTURE
+    texture_num = 46;
+#endif
+
+    const byte __far* pnames = R_TryGetLumpWithoutPurging(W_GetNumForName("PNAMES"));
+    if (!pnames)
+        return false;
+
+    const int32_t __far* maptex = R_TryGetLumpWithoutPurging(W_GetNumForName("TEXTURE1"));
+    if (!maptex)
+    {
+        Z_ChangeTagToCache(pnames);
+        return false;
+    }
+
+    const int32_t __far* directory = maptex+1;
+    const maptexture_t __far* mtexture = (const maptexture_t __far*) ((const byte __far*)maptex + directory[texture_num]);
+
+    boolean read = false;
+
+    for (int16_t j = 0; j < mtexture->patchcount; j++)
+    {
+        char pname[8];
+        _fmemcpy(pname, &pnames[4 + mtexture->patches[j].patch * 8], sizeof(pname));
+
+        if (W_PrefetchLumpByNum(W_GetNumForName(pname)))
+            read = true;
+    }
+
+    Z_ChangeTagToCache(pnames);
+    Z_ChangeTagToCache(maptex);
+
+    return read;
+}
+
 static int16_t R_GetTextureNumForName(const char* tex_name)
 {
     char name8[8];
@@ -299,4 +362,5 @@ void R_Init(void)
   R_InitSky();
   R_InitSpriteLumps();
   R_InitColormaps();
+  R_InitColumnCache();
 }
@@ -92,6 +92,7 @@ int16_t R_FlatNumForName (const char* name);   // killough -- const added
 int16_t R_CheckTextureNumForName (const char *name);
 
 const texture_t __far* R_GetTexture(int16_t texture);
+boolean R_PrefetchTexture(int16_t texture);
 void P_LoadTexture(int16_t texture);
 
 
@@ -91,6 +91,7 @@ typedef struct
   mobj_t __far* soundtarget;   // thing that made a sound (or null)
   degenmobj_t soundorg;  // origin for any sounds played by the sector
   uint16_t validcount;        // if == validcount, already checked
+  uint16_t r_validcount;      // validcount of the last frame its things were drawn in
   mobj_t __far* thinglist;     // list of mobjs in sector
 
 
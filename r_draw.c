@@ -51,6 +51,7 @@
 #include "i_system.h"
 #include "g_game.h"
 #include "m_random.h"
+#include "p_spec.h"
 
 #include "globdata.h"
 
@@ -83,6 +84,55 @@ typedef struct drawseg_s
 static drawseg_t _s_drawsegs[MAXDRAWSEGS];
 
 
+//
+// Drawsegs that can clip sprites, indexed by x.
+// Every bucket has a bit for every drawseg that overlaps its columns.
+//
+
+#define DSBUCKETWIDTH ((VIEWWINDOWWIDTH + 15) / 16)
+#define NUMDSBUCKETS  ((VIEWWINDOWWIDTH + DSBUCKETWIDTH - 1) / DSBUCKETWIDTH)
+#define NUMDSWORDS    (MAXDRAWSEGS / 16)
+
+static uint16_t dsbuckets[NUMDSBUCKETS][NUMDSWORDS];
+static uint16_t maskeddrawsegs[NUMDSWORDS];
+
+
+static void R_IndexDrawSeg(const drawseg_t* ds)
+{
+    const int16_t  num  = ds - _s_drawsegs;
+    const int16_t  w    = num >> 4;
+    const uint16_t mask = 1 << (num & 15);
+
+    for (int16_t b = ds->x1 / DSBUCKETWIDTH; b <= ds->x2 / DSBUCKETWIDTH; b++)
+        dsbuckets[b][w] |= mask;
+
+    if (ds->maskedtexturecol)
+        maskeddrawsegs[w] |= mask;
+}
+
+
+//
+// Collects the drawsegs of segs, from last to first drawn
+// Returns the number of drawsegs
+//
+static int16_t R_FindDrawSegs(const uint16_t* segs, uint8_t* dsnums)
+{
+    int16_t count = 0;
+
+    for (int16_t w = NUMDSWORDS; w-- > 0; )
+    {
+        uint16_t bits = segs[w];
+        for (int16_t num = w * 16 + 15; bits; num--, bits <<= 1)
+        {
+            if (bits & 0x8000)
+                dsnums[count++] = num;
+        }
+    }
+
+    return count;
+}
+
+
 #define MAXOPENINGS (VIEWWINDOWWIDTH*16)
 
 static int16_t openings[MAXOPENINGS];
@@ -107,6 +157,18 @@ static int16_t* lastopening;
 static const uint8_t viewangletoxTable[4096 - 1023 - VIEWANGLETOXMAX];
 
 
+#if defined VARIABLE_DETAIL
+#if VIEWWINDOWWIDTH != 240
+#error VARIABLE_DETAIL needs a VIEWWINDOWWIDTH of 240
+#endif
+
+// The view is VIEWWINDOWWIDTH >> detailshift columns wide,
+// the tables for 240 columns are used for the narrower views as well
+int16_t detailshift;
+int16_t viewwindowwidth = VIEWWINDOWWIDTH;
+#endif
+
+
 static uint8_t viewangletox(int16_t va)
 {
 #ifdef RANGECHECK
@@ -117,11 +179,15 @@ static uint8_t viewangletox(int16_t va)
 #endif
 
 	if (va < VIEWANGLETOXMAX)	//               0 <= va < VIEWANGLETOXMAX
-		return VIEWWINDOWWIDTH;
+		return viewwindowwidth;
 	else if (3073 <= va)		//            3073 <= va < 4096
 		return 0;
 	else						// VIEWANGLETOXMAX <= va < 3073
+#if defined VARIABLE_DETAIL
+		return (viewangletoxTable[va - VIEWANGLETOXMAX] + (1 << detailshift) - 1) >> detailshift; // rounded up like the narrower tables
+#else
 		return viewangletoxTable[va - VIEWANGLETOXMAX];
+#endif
 }
 
 
@@ -434,8 +500,17 @@ fixed_t  viewcos, viewsin;
 angle_t  viewangle;
 static angle16_t viewangle16;
 
+// Columns made solid by R_RenderSegLoop,
+// folded into the open runs by R_ClipWallSegment
 static byte solidcol[VIEWWINDOWWIDTH];
 
+// The columns that aren't solid yet,
+// as a sorted list of non-adjacent runs [start, end)
+#define MAXOPENRUNS ((VIEWWINDOWWIDTH + 1) / 2)
+static uint8_t openrunstart[MAXOPENRUNS];
+static uint8_t openrunend[MAXOPENRUNS];
+static int16_t numopenruns;
+
 static const seg_t     __far* curline;
 static side_t    __far* sidedef;
 static line_t    __far* linedef;
@@ -523,13 +598,24 @@ uint16_t validcount = 1;         // increment every time a check is made
 
 #define COLEXTRABITS (8 - 1)
 
+#if defined VARIABLE_DETAIL
+static int16_t CENTERX = VIEWWINDOWWIDTH  / 2;
+#else
 static const int16_t CENTERX = VIEWWINDOWWIDTH  / 2;
+#endif
        const int16_t CENTERY = VIEWWINDOWHEIGHT / 2;
 
+#if defined VARIABLE_DETAIL
+static fixed_t PROJECTION = (VIEWWINDOWWIDTH / 2L) << FRACBITS;
+
+static uint16_t PSPRITESCALE  = FRACUNIT * VIEWWINDOWWIDTH / SCREENWIDTH_VGA;
+static fixed_t  PSPRITEISCALE = FRACUNIT * SCREENWIDTH_VGA / VIEWWINDOWWIDTH; // = FixedReciprocal(PSPRITESCALE)
+#else
 static const fixed_t PROJECTION = (VIEWWINDOWWIDTH / 2L) << FRACBITS;
 
 static const uint16_t PSPRITESCALE  = FRACUNIT * VIEWWINDOWWIDTH / SCREENWIDTH_VGA;
 static const fixed_t  PSPRITEISCALE = FRACUNIT * SCREENWIDTH_VGA / VIEWWINDOWWIDTH; // = FixedReciprocal(PSPRITESCALE)
+#endif
 
 static const uint16_t PSPRITEYSCALE = FRACUNIT * (VIEWWINDOWHEIGHT * 5 / 4) / SCREENHEIGHT_VGA;
 static const uint16_t PSPRITEYFRACSTEP = (FRACUNIT * SCREENHEIGHT_VGA / (VIEWWINDOWHEIGHT * 5 / 4)) >> COLEXTRABITS; // = FixedReciprocal(PSPRITEYSCALE) >> COLEXTRABITS
@@ -1093,7 +1179,10 @@ static void R_DrawVisSprite(const vissprite_t *vis)
     // mixed with translucent/non-translucenct 2s normals
 
     if (!dcvars.colormap)   // NULL colormap = shadow draw
+    {
         colfunc = R_DrawFuzzColumn;    // killough 3/14/98
+        viewanimated = true;           // the fuzz moves
+    }
 
     // proff 11/06/98: Changed for high-res
     dcvars.fracstep = vis->fracstep;
@@ -1108,7 +1197,7 @@ static void R_DrawVisSprite(const vissprite_t *vis)
 
     dcvars.x = vis->x1;
 
-    while (dcvars.x < VIEWWINDOWWIDTH)
+    while (dcvars.x < viewwindowwidth)
     {
         const column_t __far* column = (const column_t __far*) ((const byte __far*)patch + (uint16_t)patch->columnofs[frac >> FRACBITS]);
         R_DrawMaskedColumn(colfunc, &dcvars, column);
@@ -1157,6 +1246,15 @@ static void R_GetColumn(const texture_t __far* texture, int16_t texcolumn, int16
 }
 
 
+static int16_t R_TranslateTexture(int16_t texture)
+{
+	if ((uint16_t)(texture - animated_texture_basepic) < 3)
+		viewanimated = true;
+
+	return texturetranslation[texture];
+}
+
+
 //
 // R_RenderMaskedSegRange
 //
@@ -1174,7 +1272,7 @@ static void R_RenderMaskedSegRange(const drawseg_t *ds, int16_t x1, int16_t x2)
 	frontsector = &_g_sectors[curline->frontsectornum];
 	backsector  = &_g_sectors[curline->backsectornum];
 
-	int16_t texnum = texturetranslation[_g_sides[curline->sidenum].midtexture];
+	int16_t texnum = R_TranslateTexture(_g_sides[curline->sidenum].midtexture);
 
 	// killough 4/13/98: get correct lightlevel for 2s normal textures
 	rw_lightlevel = frontsector->lightlevel;
@@ -1280,17 +1378,25 @@ static void R_DrawSprite (const vissprite_t* spr)
 
     // Scan drawsegs from end to start for obscuring segs.
     // The first drawseg that has a greater scale is the clip seg.
+    // Only the drawsegs in the buckets of the sprite can cover it.
 
-    // Modified by Lee Killough:
-    // (pointer check was originally nonportable
-    // and buggy, by going past LEFT end of array):
+    uint16_t segs[NUMDSWORDS];
+    memcpy(segs, dsbuckets[spr->x1 / DSBUCKETWIDTH], sizeof(segs));
+    for (int16_t b = spr->x1 / DSBUCKETWIDTH + 1; b <= spr->x2 / DSBUCKETWIDTH; b++)
+    {
+        for (int16_t w = 0; w < NUMDSWORDS; w++)
+            segs[w] |= dsbuckets[b][w];
+    }
 
-    const drawseg_t* drawsegs  =_s_drawsegs;
+    uint8_t dsnums[MAXDRAWSEGS];
+    const int16_t numds = R_FindDrawSegs(segs, dsnums);
 
-    for (const drawseg_t* ds = ds_p; ds-- > drawsegs; )  // new -- killough
+    for (int16_t i = 0; i < numds; i++)
     {
+        const drawseg_t* ds = &_s_drawsegs[dsnums[i]];
+
         // determine if the drawseg obscures the sprite
-        if (ds->x1 > spr->x2 || ds->x2 < spr->x1 || (!ds->silhouette && !ds->maskedtexturecol))
+        if (ds->x1 > spr->x2 || ds->x2 < spr->x1)
             continue;      // does not cover sprite
 
         const int16_t r1 = ds->x1 < spr->x1 ? spr->x1 : ds->x1;
@@ -1401,7 +1507,7 @@ static void R_DrawPSprite (pspdef_t *psp, int16_t lightlevel)
     x2 = CENTERX + (hl >> FRACBITS) - 1;
 
     // off the side
-    if (x2 < 0 || x1 > VIEWWINDOWWIDTH)
+    if (x2 < 0 || x1 > viewwindowwidth)
     {
         Z_ChangeTagToCache(patch);
         return;
@@ -1416,7 +1522,7 @@ static void R_DrawPSprite (pspdef_t *psp, int16_t lightlevel)
     vis->texturemid = (BASEYCENTER<<FRACBITS) /* +  FRACUNIT/2 */ -
             (psp->sy-topoffset);
     vis->x1 = x1 < 0 ? 0 : x1;
-    vis->x2 = x2 >= VIEWWINDOWWIDTH ? VIEWWINDOWWIDTH - 1 : x2;
+    vis->x2 = x2 >= viewwindowwidth ? viewwindowwidth - 1 : x2;
     // proff 11/06/98: Added for high-res
     vis->scale = PSPRITEYSCALE;
     vis->fracstep = PSPRITEYFRACSTEP;
@@ -1508,10 +1614,6 @@ static void R_SortVisSprites (void)
 
 static void R_DrawMasked(void)
 {
-    drawseg_t *ds;
-    drawseg_t* drawsegs = _s_drawsegs;
-
-
     R_SortVisSprites();
 
     // draw all vissprites back to front
@@ -1520,9 +1622,14 @@ static void R_DrawMasked(void)
 
     // render any remaining masked mid textures
 
-    for (ds=ds_p ; ds-- > drawsegs ; )
-        if (ds->maskedtexturecol)
-            R_RenderMaskedSegRange(ds, ds->x1, ds->x2);
+    uint8_t dsnums[MAXDRAWSEGS];
+    const int16_t numds = R_FindDrawSegs(maskeddrawsegs, dsnums);
+
+    for (int16_t i = 0; i < numds; i++)
+    {
+        const drawseg_t* ds = &_s_drawsegs[dsnums[i]];
+        R_RenderMaskedSegRange(ds, ds->x1, ds->x2);
+    }
 
     R_DrawPlayerSprites ();
 }
@@ -1568,7 +1675,7 @@ static void R_ClearSprites(void)
 
 static fixed_t R_ScaleFromGlobalAngle(int16_t x)
 {
-  int16_t anglea = ANG90_16 + xtoviewangleTable[x];
+  int16_t anglea = ANG90_16 + xtoviewangle(x);
   int16_t angleb = anglea + viewangle16 - rw_normalangle;
 
   fixed_t den = rw_distance * finesineapprox(anglea >> ANGLETOFINESHIFT_16);
@@ -1651,7 +1758,7 @@ static void R_ProjectSprite (mobj_t __far* thing, int16_t lightlevel)
     const int16_t x1 = (xl >> FRACBITS);
 
     // off the side?
-    if (x1 > VIEWWINDOWWIDTH)
+    if (x1 > viewwindowwidth)
     {
         Z_ChangeTagToCache(patch);
         return;
@@ -1695,7 +1802,7 @@ static void R_ProjectSprite (mobj_t __far* thing, int16_t lightlevel)
     vis->gz              = fz;
     vis->texturemid      = (fz + (((int32_t)patch->topoffset) << FRACBITS)) - viewz;
     vis->x1              = x1 < 0 ? 0 : x1;
-    vis->x2              = x2 >= VIEWWINDOWWIDTH ? VIEWWINDOWWIDTH - 1 : x2;
+    vis->x2              = x2 >= viewwindowwidth ? viewwindowwidth - 1 : x2;
 
 
     const fixed_t iscale = FixedReciprocal(xscale);
@@ -1746,7 +1853,8 @@ static void R_AddSprites(subsector_t __far* subsec, int16_t lightlevel)
     return;
 
   // Well, now it will be done.
-  sec->validcount = validcount;
+  sec->validcount   = validcount;
+  sec->r_validcount = validcount;
 
   // Handle all things in sector.
 
@@ -1757,6 +1865,20 @@ static void R_AddSprites(subsector_t __far* subsec, int16_t lightlevel)
 
 #if defined FLAT_WALL
 #define R_DrawSegTextureColumn(w,x,y,z) R_DrawColumnFlat(x,z)
+#endif
+
+#if defined FLAT_WALL || defined PRECOMPOSED_TEXTURES
+// No composite textures, so no column cache
+
+void R_InitColumnCache(void)
+{
+}
+
+void R_GetColumnCacheStats(uint32_t* hits, uint32_t* misses)
+{
+	*hits   = 0;
+	*misses = 0;
+}
 #else
 static void R_DrawColumnInCache(const column_t __far* patch, byte* cache, int16_t originy, int16_t cacheheight)
 {
@@ -1788,34 +1910,109 @@ static void R_DrawColumnInCache(const column_t __far* patch, byte* cache, int16_
  * straight from const patch_t*.
 */
 
-#define MAX_CACHE_ENTRIES 128
-#define MAX_CACHE_TRIES 4
+//
+// Composite texture column cache
+// 4-way set associative, with the least recently used way
+// of a set replaced on a miss.
+// The number of sets is chosen at startup from the free zone memory.
+//
+
+#define CACHE_WAYS		4
+#define CACHE_COLUMNSIZE	128
+#define MIN_CACHE_SETS		8
+#define MAX_CACHE_SETS		64
+#define CACHE_EMPTY		0xffff
+
+#if defined HIGH_DETAIL
+#define CACHE_COLUMNSHIFT 0
+#else
+#define CACHE_COLUMNSHIFT 2
+#endif
 
 static uint16_t CACHE_ENTRY(int16_t column, int16_t texture)
 {
 	return column | (texture << 8);
 }
 
-static byte __far columnCache[MAX_CACHE_ENTRIES*128];
-static uint16_t columnCacheEntries[MAX_CACHE_ENTRIES];
+static byte __far* columnCache;
+static uint16_t columnCacheSetMask;
+static uint16_t columnCacheEntries[MAX_CACHE_SETS * CACHE_WAYS];
+
+// The ways of a set from most to least recently used, two bits each
+static uint8_t columnCacheOrder[MAX_CACHE_SETS];
+#define CACHE_ORDER_INIT (0 | (1 << 2) | (2 << 4) | (3 << 6))
+
+static uint32_t columnCacheHits;
+static uint32_t columnCacheMisses;
+
+
+void R_InitColumnCache(void)
+{
+	// use at most 1/16 of the free memory
+	uint32_t maxsize = Z_GetTotalFreeMemory() / 16;
+
+	uint16_t numsets = MAX_CACHE_SETS;
+	while (numsets > MIN_CACHE_SETS && (uint32_t)numsets * CACHE_WAYS * CACHE_COLUMNSIZE > maxsize)
+		numsets /= 2;
+
+	columnCache        = Z_MallocStatic(numsets * CACHE_WAYS * CACHE_COLUMNSIZE);
+	columnCacheSetMask = numsets - 1;
+
+	for (uint16_t i = 0; i < numsets * CACHE_WAYS; i++)
+		columnCacheEntries[i] = CACHE_EMPTY;
+
+	for (uint16_t i = 0; i < numsets; i++)
+		columnCacheOrder[i] = CACHE_ORDER_INIT;
+}
+
+
+void R_GetColumnCacheStats(uint32_t* hits, uint32_t* misses)
+{
+	*hits   = columnCacheHits;
+	*misses = columnCacheMisses;
+}
+
+
+// Makes a way the most recently used one of its set
+static uint8_t R_TouchCacheWay(uint8_t order, uint8_t way)
+{
+	uint8_t shift = 0;
+	while (((order >> shift) & 3) != way)
+		shift += 2;
+
+	uint8_t newer = order & ((1 << shift) - 1);
+	uint8_t older = (order >> shift) >> 2;
+	return way | (newer << 2) | ((older << shift) << 2);
+}
+
 
-static uint16_t FindColumnCacheItem(int16_t texture, int16_t column)
+// Returns the index of the cache entry for the column,
+// sets *hit if it holds the column already
+static uint16_t FindColumnCacheItem(int16_t texture, int16_t column, boolean* hit)
 {
-	uint16_t hash = ((column >> 2) ^ (texture * 71)) & (MAX_CACHE_ENTRIES - 1);
-	uint16_t key = hash;
+	uint16_t set  = ((column >> CACHE_COLUMNSHIFT) ^ (texture * 71)) & columnCacheSetMask;
+	uint16_t base = set * CACHE_WAYS;
 
 	uint16_t cx = CACHE_ENTRY(column, texture);
 
-	for (int16_t i = 0; i < MAX_CACHE_TRIES; i++)
+	uint8_t way;
+	for (way = 0; way < CACHE_WAYS; way++)
 	{
-		if (columnCacheEntries[key] == 0 || columnCacheEntries[key] == cx)
-			return key;
+		if (columnCacheEntries[base + way] == cx)
+			break;
+	}
 
-		key += 119;
-		key &= (MAX_CACHE_ENTRIES - 1);
+	*hit = way < CACHE_WAYS;
+	if (*hit)
+		columnCacheHits++;
+	else
+	{
+		columnCacheMisses++;
+		way = columnCacheOrder[set] >> 6; // least recently used
 	}
 
-	return hash;
+	columnCacheOrder[set] = R_TouchCacheWay(columnCacheOrder[set], way);
+	return base + way;
 }
 
 
@@ -1827,17 +2024,14 @@ static const byte __far* R_ComposeColumn(const int16_t texture, const texture_t
     const int16_t xc = (texcolumn & 0xfffc) & tex->widthmask;
 #endif
 
-    uint16_t cachekey = FindColumnCacheItem(texture, xc);
+    boolean hit;
+    uint16_t cachekey = FindColumnCacheItem(texture, xc, &hit);
 
-    byte __far* colcache = &columnCache[cachekey*128];
-    uint16_t cacheEntry = columnCacheEntries[cachekey];
+    byte __far* colcache = &columnCache[cachekey * CACHE_COLUMNSIZE];
 
-    //total++;
-
-    if (cacheEntry != CACHE_ENTRY(xc, texture))
+    if (!hit)
     {
-        //misses++;
-        static byte tmpCache[128];
+        static byte tmpCache[CACHE_COLUMNSIZE];
 
         uint8_t i = 0;
         uint8_t patchcount = tex->patchcount;
@@ -1851,7 +2045,7 @@ static const byte __far* R_ComposeColumn(const int16_t texture, const texture_t
             if (xc < x1)
                 continue;
 
-            const patch_t __far* realpatch = W_TryGetLumpByNum(patch->patch_num);
+            const patch_t __far* realpatch = W_PinLump(patch->patch_num);
             if (realpatch == NULL)
                 return NULL;
 
@@ -1863,7 +2057,7 @@ static const byte __far* R_ComposeColumn(const int16_t texture, const texture_t
 
                 R_DrawColumnInCache (patchcol, tmpCache, patch->originy, tex->height);
             }
-            Z_ChangeTagToCache(realpatch);
+            W_UnpinLump(patch->patch_num);
         } while(++i < patchcount);
 
         //Block copy will drop low 2 bits of len.
@@ -1874,16 +2068,20 @@ static const byte __far* R_ComposeColumn(const int16_t texture, const texture_t
 
     return colcache;
 }
+#endif
 
+#if !defined FLAT_WALL
 static void R_DrawSegTextureColumn(const texture_t __far* tex, int16_t texture, int16_t texcolumn, draw_column_vars_t* dcvars)
 {
+#if !defined PRECOMPOSED_TEXTURES
     if (!tex->overlapped)
+#endif
     {
         int16_t patch_num;
         int16_t x_c;
         R_GetColumn(tex, texcolumn, &patch_num, &x_c);
 
-        const patch_t __far* patch = W_TryGetLumpByNum(patch_num);
+        const patch_t __far* patch = W_PinLump(patch_num);
         if (patch == NULL)
             R_DrawColumnFlat(texture, dcvars);
         else
@@ -1892,9 +2090,10 @@ static void R_DrawSegTextureColumn(const texture_t __far* tex, int16_t texture,
 
             dcvars->source = (const byte __far*)column + 3;
             R_DrawColumnWall(dcvars);
-            Z_ChangeTagToCache(patch);
+            W_UnpinLump(patch_num);
         }
     }
+#if !defined PRECOMPOSED_TEXTURES
     else
     {
         const byte __far* source = R_ComposeColumn(texture, tex, texcolumn);
@@ -1906,9 +2105,150 @@ static void R_DrawSegTextureColumn(const texture_t __far* tex, int16_t texture,
             R_DrawColumnWall(dcvars);
         }
     }
+#endif
 }
 #endif
 
+#if defined FLAT_SPAN
+//
+// Flat colored floors and ceilings
+// R_RenderSegLoop collects the rows of the floor and the ceiling
+// per column of a seg. Afterwards they're drawn as horizontal spans
+// when those add up to fewer draw calls than the columns,
+// otherwise as columns.
+//
+
+typedef struct
+{
+	uint8_t  top[VIEWWINDOWWIDTH];
+	uint8_t  bottom[VIEWWINDOWWIDTH];
+	uint16_t numcolumns;
+	uint16_t numspans;
+	int16_t  prevtop;
+	int16_t  prevbottom;
+} flatrows_t;
+
+#define FLAT_EMPTY_TOP		VIEWWINDOWHEIGHT
+#define FLAT_EMPTY_BOTTOM	0
+
+static flatrows_t ceilingrows;
+static flatrows_t floorrows;
+
+// the column where the span of a row started
+static uint8_t spanstart[VIEWWINDOWHEIGHT];
+
+
+static void R_ClearFlatRows(flatrows_t* rows)
+{
+	rows->numcolumns = 0;
+	rows->numspans   = 0;
+	rows->prevtop    = FLAT_EMPTY_TOP;
+	rows->prevbottom = FLAT_EMPTY_BOTTOM;
+}
+
+
+static void R_AddFlatColumn(flatrows_t* rows, int16_t x, int16_t top, int16_t bottom)
+{
+	int16_t prevtop    = rows->prevtop;
+	int16_t prevbottom = rows->prevbottom;
+
+	if (top > bottom)
+	{
+		top    = FLAT_EMPTY_TOP;
+		bottom = FLAT_EMPTY_BOTTOM;
+	}
+	else
+	{
+		rows->numcolumns++;
+
+		// count the rows that start a span in this column
+		if (prevtop > prevbottom)
+			rows->numspans += bottom - top + 1;
+		else
+		{
+			int16_t above = (bottom < prevtop - 1 ? bottom : prevtop - 1) - top + 1;
+			int16_t below = bottom - (top > prevbottom + 1 ? top : prevbottom + 1) + 1;
+			if (above > 0)
+				rows->numspans += above;
+			if (below > 0)
+				rows->numspans += below;
+		}
+	}
+
+	rows->top[x]    = top;
+	rows->bottom[x] = bottom;
+	rows->prevtop    = top;
+	rows->prevbottom = bottom;
+}
+
+
+static void R_EndFlatSpans(uint8_t color, int16_t y1, int16_t y2, int16_t x)
+{
+	for (int16_t y = y1; y <= y2; y++)
+		R_DrawSpanFlat(color, y, spanstart[y], x - 1);
+}
+
+
+static void R_StartFlatSpans(int16_t y1, int16_t y2, int16_t x)
+{
+	for (int16_t y = y1; y <= y2; y++)
+		spanstart[y] = x;
+}
+
+
+static void R_DrawFlatRows(const flatrows_t* rows, uint8_t color, int16_t start, int16_t stop)
+{
+	if (rows->numcolumns == 0)
+		return;
+
+	if (rows->numspans > rows->numcolumns)
+	{
+		draw_column_vars_t dcvars;
+
+		for (int16_t x = start; x < stop; x++)
+		{
+			if (rows->top[x] <= rows->bottom[x])
+			{
+				dcvars.x  = x;
+				dcvars.yl = rows->top[x];
+				dcvars.yh = rows->bottom[x];
+				R_DrawColumnFlat(color, &dcvars);
+			}
+		}
+		return;
+	}
+
+	int16_t prevtop    = FLAT_EMPTY_TOP;
+	int16_t prevbottom = FLAT_EMPTY_BOTTOM;
+
+	for (int16_t x = start; x < stop; x++)
+	{
+		int16_t top    = rows->top[x];
+		int16_t bottom = rows->bottom[x];
+
+		if (top > bottom)
+			R_EndFlatSpans(color, prevtop, prevbottom, x);
+		else if (prevtop > prevbottom)
+			R_StartFlatSpans(top, bottom, x);
+		else
+		{
+			// end the rows that aren't in this column,
+			// start the rows that weren't in the previous column
+			R_EndFlatSpans(color, prevtop, top - 1 < prevbottom ? top - 1 : prevbottom, x);
+			R_EndFlatSpans(color, bottom + 1 > prevtop ? bottom + 1 : prevtop, prevbottom, x);
+			R_StartFlatSpans(top, bottom < prevtop - 1 ? bottom : prevtop - 1, x);
+			R_StartFlatSpans(top > prevbottom + 1 ? top : prevbottom + 1, bottom, x);
+		}
+
+		prevtop    = top;
+		prevbottom = bottom;
+	}
+
+	R_EndFlatSpans(color, prevtop, prevbottom, stop);
+}
+#endif
+
+
 //
 // R_RenderSegLoop
 // Draws zero, one, or two textures (and possibly a masked texture) for walls.
@@ -1925,6 +2265,12 @@ static void R_RenderSegLoop(int16_t rw_x, boolean segtextured, boolean markfloor
 
     dcvars.colormap = R_LoadColorMap(rw_lightlevel);
 
+#if defined FLAT_SPAN
+    const int16_t rw_startx = rw_x;
+    R_ClearFlatRows(&ceilingrows);
+    R_ClearFlatRows(&floorrows);
+#endif
+
     for ( ; rw_x < rw_stopx ; rw_x++)
     {
         // mark floor / ceiling areas
@@ -1950,21 +2296,23 @@ static void R_RenderSegLoop(int16_t rw_x, boolean segtextured, boolean markfloor
             if (bottom >= fc_rwx)
                 bottom = fc_rwx-1;
 
-            if (top <= bottom)
-            {
 #if defined FLAT_SPAN
+            if (ceilingplane_color != -2)
+                R_AddFlatColumn(&ceilingrows, rw_x, top, bottom);
+            else if (top <= bottom)
+            {
                 dcvars.yl = top;
                 dcvars.yh = bottom;
-                if (ceilingplane_color == -2)
-                    R_DrawSky(&dcvars);
-                else
-                    R_DrawColumnFlat(ceilingplane_color, &dcvars);
+                R_DrawSky(&dcvars);
+            }
 #else
+            if (top <= bottom)
+            {
                 ceilingplane->top[rw_x] = top;
                 ceilingplane->bottom[rw_x] = bottom;
                 ceilingplane->modified = true;
-#endif
             }
+#endif
             // SoM: this should be set here
             cc_rwx = bottom;
         }
@@ -1978,18 +2326,17 @@ static void R_RenderSegLoop(int16_t rw_x, boolean segtextured, boolean markfloor
 
             top  = yh < cc_rwx ? cc_rwx : yh;
 
-            if (++top <= bottom)
-            {
+            ++top;
 #if defined FLAT_SPAN
-                dcvars.yl = top;
-                dcvars.yh = bottom;
-                R_DrawColumnFlat(floorplane_color, &dcvars);
+            R_AddFlatColumn(&floorrows, rw_x, top, bottom);
 #else
+            if (top <= bottom)
+            {
                 floorplane->top[rw_x] = top;
                 floorplane->bottom[rw_x] = bottom;
                 floorplane->modified = true;
-#endif
             }
+#endif
             // SoM: This should be set here to prevent overdraw
             fc_rwx = top;
         }
@@ -2000,7 +2347,7 @@ static void R_RenderSegLoop(int16_t rw_x, boolean segtextured, boolean markfloor
             // calculate texture offset
 #if !defined FLAT_WALL
 			texturecolumn = rw_offset;
-			int16_t ang = (angle16_t)(rw_centerangle + xtoviewangleTable[rw_x]) >> ANGLETOFINESHIFT_16;
+			int16_t ang = (angle16_t)(rw_centerangle + xtoviewangle(rw_x)) >> ANGLETOFINESHIFT_16;
 			if (ang < 1024) {			//    0 <= ang < 1024
 				fixed_t tan = finetangentTable_part_4[1023 - ang];
 				texturecolumn += (rw_distance * tan) >> FRACBITS;
@@ -2114,6 +2461,14 @@ static void R_RenderSegLoop(int16_t rw_x, boolean segtextured, boolean markfloor
         floorclip[rw_x] = fc_rwx;
         ceilingclip[rw_x] = cc_rwx;
     }
+
+#if defined FLAT_SPAN
+    if (markceiling && ceilingplane_color != -2)
+        R_DrawFlatRows(&ceilingrows, ceilingplane_color, rw_startx, rw_stopx);
+
+    if (markfloor)
+        R_DrawFlatRows(&floorrows, floorplane_color, rw_startx, rw_stopx);
+#endif
 }
 
 static boolean R_CheckOpenings(const int16_t start)
@@ -2133,7 +2488,7 @@ static boolean R_CheckOpenings(const int16_t start)
 static void R_ClearOpeningClippingDetermination(void)
 {
 	// opening / clipping determination
-	for (uint8_t i = 0; i < VIEWWINDOWWIDTH; i++)
+	for (uint8_t i = 0; i < viewwindowwidth; i++)
 		floorclip[i] = VIEWWINDOWHEIGHT, ceilingclip[i] = -1;
 }
 
@@ -2238,7 +2593,7 @@ static void R_StoreWallRange(const int16_t start, const int16_t stop)
     if (!backsector)
     {
         // single sided line
-        midtexture = texturetranslation[sidedef->midtexture];
+        midtexture = R_TranslateTexture(sidedef->midtexture);
         texmidtexture = R_GetTexture(midtexture);
 
         // a single sided line is terminal, so it must mark ends
@@ -2332,7 +2687,7 @@ static void R_StoreWallRange(const int16_t start, const int16_t stop)
 
         if (worldhigh < worldtop)   // top texture
         {
-            toptexture = texturetranslation[sidedef->toptexture];
+            toptexture = R_TranslateTexture(sidedef->toptexture);
             textoptexture = R_GetTexture(toptexture);
             rw_toptexturemid = linedef->flags & ML_DONTPEGTOP ? worldtop :
                                                                         backsector->ceilingheight + ((int32_t)textureheight[sidedef->toptexture] << FRACBITS) - viewz;
@@ -2341,7 +2696,7 @@ static void R_StoreWallRange(const int16_t start, const int16_t stop)
 
         if (worldlow > worldbottom) // bottom texture
         {
-            bottomtexture = texturetranslation[sidedef->bottomtexture];
+            bottomtexture = R_TranslateTexture(sidedef->bottomtexture);
             texbottomtexture = R_GetTexture(bottomtexture);
             rw_bottomtexturemid = linedef->flags & ML_DONTPEGBOTTOM ? worldtop : worldlow;
 
@@ -2481,6 +2836,9 @@ static void R_StoreWallRange(const int16_t start, const int16_t stop)
         ds_p->bsilheight = INT32_MAX;
     }
 
+    if (ds_p->silhouette || ds_p->maskedtexturecol)
+        R_IndexDrawSeg(ds_p);
+
     ds_p++;
 }
 
@@ -2546,35 +2904,90 @@ static void R_RecalcLineFlags(void)
 // Replaces the old R_Clip*WallSegment functions. It draws bits of walls in those
 // columns which aren't solid, and updates the solidcol[] array appropriately
 
-static void R_ClipWallSegment(int16_t first, int16_t last, const boolean solid)
+//
+// R_CloseColumns
+// Replaces the columns [start, end) of open run i
+// by the columns that are still open.
+// Returns the index of the run after them.
+//
+
+static int16_t R_CloseColumns(int16_t i, int16_t start, int16_t end, const boolean solid)
 {
-    byte *p;
-    while (first < last)
+    uint8_t runstart[MAXOPENRUNS];
+    uint8_t runend[MAXOPENRUNS];
+    int16_t n = 0;
+
+    if (openrunstart[i] < start)
     {
-        if (solidcol[first])
+        runstart[n] = openrunstart[i];
+        runend[n]   = start;
+        n++;
+    }
+
+    if (!solid)
+    {
+        int16_t x = start;
+        while (x < end)
         {
-            if (!(p = memchr(solidcol+first, 0, last-first)))
-                return; // All solid
+            while (x < end && solidcol[x])
+                x++;
+
+            if (x == end)
+                break;
+
+            if (n && runend[n - 1] == x)
+                n--;
+            else
+                runstart[n] = x;
 
-            first = p - solidcol;
+            while (x < end && !solidcol[x])
+                x++;
+
+            runend[n] = x;
+            n++;
         }
+    }
+
+    if (end < openrunend[i])
+    {
+        if (n && runend[n - 1] == end)
+            n--;
         else
-        {
-            int16_t to;
-            if (!(p = memchr(solidcol+first, 1, last-first)))
-                to = last;
-            else
-                to = p - solidcol;
+            runstart[n] = end;
+
+        runend[n] = openrunend[i];
+        n++;
+    }
 
-            R_StoreWallRange(first, to-1);
+    memmove(&openrunstart[i + n], &openrunstart[i + 1], numopenruns - i - 1);
+    memmove(&openrunend[i + n],   &openrunend[i + 1],   numopenruns - i - 1);
+    memcpy(&openrunstart[i], runstart, n);
+    memcpy(&openrunend[i],   runend,   n);
+    numopenruns += n - 1;
 
-            if (solid)
-            {
-                memset(solidcol + first, 1, to - first);
-            }
+    return i + n;
+}
 
-            first = to;
-        }
+
+static void R_ClipWallSegment(int16_t first, int16_t last, const boolean solid)
+{
+    int16_t i = 0;
+    while (i < numopenruns && openrunend[i] <= first)
+        i++;
+
+    while (i < numopenruns && openrunstart[i] < last)
+    {
+        int16_t start = openrunstart[i] > first ? openrunstart[i] : first;
+        int16_t end   = openrunend[i]   < last  ? openrunend[i]   : last;
+
+        I_ProfileStage(PROF_WALLS);
+        R_StoreWallRange(start, end - 1);
+        I_ProfileStage(PROF_BSP);
+
+        if (solid || didsolidcol)
+            i = R_CloseColumns(i, start, end, solid);
+        else
+            i++;
     }
 }
 
@@ -2643,6 +3056,10 @@ static void R_AddLine(const seg_t __far* line)
 
     backsector = line->backsectornum != NO_INDEX8 ? &_g_sectors[line->backsectornum] : NULL;
 
+    // the heights of the back sector determine what is drawn of this seg
+    if (backsector)
+        backsector->r_validcount = validcount;
+
     /* cph - roll up linedef properties in flags */
     linedef = &_g_lines[curline->linenum];
 
@@ -2749,6 +3166,10 @@ static const byte checkcoord[12][4] =
 
 static boolean R_CheckBBox(const int16_t __far* bspcoord)
 {
+    // Every column is solid
+    if (numopenruns == 0)
+        return false;
+
     // Find the corners of the box
     // that define the edges from current viewpoint.
     int16_t boxpos = (viewx <= ((fixed_t)bspcoord[BOXLEFT]<<FRACBITS) ? 0 : viewx < ((fixed_t)bspcoord[BOXRIGHT]<<FRACBITS) ? 1 : 2) +
@@ -2792,15 +3213,104 @@ static boolean R_CheckBBox(const int16_t __far* bspcoord)
     if (sx1 == sx2)
         return false;
 
-    if (!memchr(solidcol+sx1, 0, sx2-sx1)) return false;
-    // All columns it covers are already solidly covered
+    // Is any column it covers still open?
+    int16_t i = 0;
+    while (i < numopenruns && openrunend[i] <= sx1)
+        i++;
+
+    if (i == numopenruns || openrunstart[i] >= sx2)
+        return false;
 
 
     return true;
 }
 
+//
+// Potentially visible set
+// The row of the subsector of the view point is decompressed
+// into one bit per subsector, and one bit per node
+// that is set when one of its children is potentially visible.
+//
+
+static const mappvs_t __far* pvs;
+static byte __far* pvsleaves;
+static byte __far* pvsnodes;
+static int16_t pvssubsector;
+
+
+void R_InitPVS(const mappvs_t __far* data)
+{
+    pvs          = data;
+    pvssubsector = -1;
+
+    if (pvs)
+    {
+        pvsleaves = Z_MallocLevel((pvs->numsubsectors + 7) / 8 + (pvs->numnodes + 7) / 8, NULL);
+        pvsnodes  = pvsleaves + (pvs->numsubsectors + 7) / 8;
+    }
+}
+
+
+static boolean R_IsInPVS(uint16_t bspnum)
+{
+    if (bspnum & NF_SUBSECTOR)
+    {
+        uint16_t num = bspnum == 0xffff ? 0 : bspnum & ~NF_SUBSECTOR;
+        return pvsleaves[num >> 3] & (1 << (num & 7));
+    }
+    else
+        return pvsnodes[bspnum >> 3] & (1 << (bspnum & 7));
+}
+
+
+static void R_SetupPVS(int16_t subsector)
+{
+    if (!pvs || subsector == pvssubsector)
+        return;
+
+    pvssubsector = subsector;
+
+    const uint16_t __far* offsets = (const uint16_t __far*)(pvs + 1);
+    const byte __far* src = (const byte __far*)pvs + offsets[subsector];
+    byte __far* dest      = pvsleaves;
+    byte __far* end       = pvsleaves + (pvs->numsubsectors + 7) / 8;
+
+    while (dest < end)
+    {
+        byte b = *src++;
+        if (b)
+            *dest++ = b;
+        else
+        {
+            byte run = *src++;
+            _fmemset(dest, 0, run);
+            dest += run;
+        }
+    }
+
+    // Node builders write the children before their parent.
+    // If one doesn't, the parent is always visible.
+    _fmemset(pvsnodes, 0, (pvs->numnodes + 7) / 8);
+
+    for (int16_t i = 0; i < pvs->numnodes; i++)
+    {
+        const mapnode_t __far* bsp = &nodes[i];
+
+        for (int16_t side = 0; side < 2; side++)
+        {
+            uint16_t child = bsp->children[side];
+            if ((!(child & NF_SUBSECTOR) && child >= (uint16_t)i) || R_IsInPVS(child))
+            {
+                pvsnodes[i >> 3] |= 1 << (i & 7);
+                break;
+            }
+        }
+    }
+}
+
+
 //Render a BSP subsector if bspnum is a leaf node.
-//Return false if bspnum is frame node.
+//Return false if bspnum is a node that has to be traversed.
 
 
 
@@ -2808,6 +3318,10 @@ static boolean R_CheckBBox(const int16_t __far* bspcoord)
 
 static boolean R_RenderBspSubsector(int16_t bspnum)
 {
+    // Can't be seen from the view point?
+    if (pvs && !R_IsInPVS(bspnum))
+        return true;
+
     // Found a subsector?
     if (bspnum & NF_SUBSECTOR)
     {
@@ -2844,6 +3358,10 @@ static void R_RenderBSPNode(int16_t bspnum)
 
     while (true)
     {
+        //The screen is full.
+        if (numopenruns == 0)
+            return;
+
         //Front sides.
         while (!R_RenderBspSubsector(bspnum))
         {
@@ -2897,6 +3415,10 @@ static void R_RenderBSPNode(int16_t bspnum)
 #else
 static void R_RenderBSPNode(int16_t bspnum)
 {
+	// The screen is full
+	if (numopenruns == 0)
+		return;
+
 	if (R_RenderBspSubsector(bspnum))
 		return;
 
@@ -2918,11 +3440,18 @@ static void R_RenderBSPNode(int16_t bspnum)
 static void R_ClearDrawSegs(void)
 {
     ds_p = _s_drawsegs;
+
+    memset(dsbuckets,      0, sizeof(dsbuckets));
+    memset(maskeddrawsegs, 0, sizeof(maskeddrawsegs));
 }
 
 static void R_ClearClipSegs (void)
 {
-    memset(solidcol, 0, VIEWWINDOWWIDTH);
+    memset(solidcol, 0, viewwindowwidth);
+
+    openrunstart[0] = 0;
+    openrunend[0]   = viewwindowwidth;
+    numopenruns = 1;
 }
 
 
@@ -2955,13 +3484,126 @@ static void R_SetupFrame (player_t *player)
 }
 
 
+//
+// Frame reuse
+// D_Display shows the view window of the previous frame again
+// when nothing that was drawn in it has changed.
+//
+
+typedef struct
+{
+    fixed_t x, y, z;
+    angle_t angle;
+    int16_t extralight;
+    int16_t fixedcolormap;
+    boolean shadow;
+    const state_t* pspstate[NUMPSPRITES];
+    int16_t pspsx[NUMPSPRITES];
+    fixed_t pspsy[NUMPSPRITES];
+} viewstate_t;
+
+static viewstate_t lastviewstate;
+static boolean viewchanged = true;
+static uint16_t viewvalidcount;
+
+boolean viewanimated;
+
+
+static void R_GetViewState(const player_t* player, viewstate_t* vs)
+{
+    memset(vs, 0, sizeof(*vs));
+
+    vs->x             = player->mo->x;
+    vs->y             = player->mo->y;
+    vs->z             = player->viewz;
+    vs->angle         = player->mo->angle;
+    vs->extralight    = player->extralight;
+    vs->fixedcolormap = player->fixedcolormap;
+    vs->shadow        = player->powers[pw_invisibility] > 4*32 || player->powers[pw_invisibility] & 8;
+
+    for (int16_t i = 0; i < NUMPSPRITES; i++)
+    {
+        vs->pspstate[i] = player->psprites[i].state;
+        vs->pspsx[i]    = player->psprites[i].sx;
+        vs->pspsy[i]    = player->psprites[i].sy;
+    }
+}
+
+
+boolean R_IsViewUnchanged(const player_t* player)
+{
+    if (viewchanged)
+        return false;
+
+    viewstate_t vs;
+    R_GetViewState(player, &vs);
+    return memcmp(&vs, &lastviewstate, sizeof(viewstate_t)) == 0;
+}
+
+
+void R_InvalidateView(void)
+{
+    viewchanged = true;
+}
+
+
+#if defined VARIABLE_DETAIL
+//
+// R_SetDetail
+// 0 is high, 1 is medium and 2 is low detail,
+// takes effect from the next frame on
+//
+void R_SetDetail(int16_t shift)
+{
+    detailshift     = shift;
+    viewwindowwidth = VIEWWINDOWWIDTH >> shift;
+
+    CENTERX       = viewwindowwidth / 2;
+    PROJECTION    = ((fixed_t)viewwindowwidth / 2) << FRACBITS;
+    PSPRITESCALE  = FRACUNIT * viewwindowwidth / SCREENWIDTH_VGA;
+    PSPRITEISCALE = FRACUNIT * SCREENWIDTH_VGA / viewwindowwidth;
+
+    R_InvalidateView();
+}
+#endif
+
+
+// Called when the animated flats and textures change
+void R_InvalidateAnimation(void)
+{
+    if (viewanimated)
+        viewchanged = true;
+}
+
+
+void R_InvalidateSector(const sector_t __far* sector)
+{
+    if (sector->r_validcount == viewvalidcount)
+        viewchanged = true;
+}
+
+
+void R_InvalidateMobj(const mobj_t __far* mobj)
+{
+    if (!(mobj->flags & MF_NOSECTOR) && mobj->subsector)
+        R_InvalidateSector(mobj->subsector->sector);
+}
+
+
 //
 // R_RenderView
 //
 void R_RenderPlayerView (player_t* player)
 {
+    I_ProfileStage(PROF_SETUPFRAME);
+
     R_SetupFrame (player);
 
+    R_GetViewState(player, &lastviewstate);
+    viewchanged    = false;
+    viewanimated   = false;
+    viewvalidcount = validcount;
+
     // Clear buffers.
     R_ClearClipSegs ();
     R_ClearDrawSegs ();
@@ -2974,16 +3616,32 @@ void R_RenderPlayerView (player_t* player)
     R_ClearOpenings ();
     R_ClearSprites ();
 
+    R_SetupPVS (player->mo->subsector - _g_subsectors);
+
+    I_ProfileStage(PROF_BSP);
+
     // The head node is the last node output.
     R_RenderBSPNode (numnodes-1);
 
+    // With FLAT_SPAN the flats are drawn by the walls
+    I_ProfileStage(PROF_PLANES);
+
 #if defined FLAT_SPAN
     R_FreeSkyPatch ();
 #else
     R_DrawPlanes ();
 #endif
 
+    // Release the wall and flat lumps, the sprites need the memory
+    W_UnpinFrame ();
+
+    I_ProfileStage(PROF_MASKED);
+
     R_DrawMasked ();
+
+    W_UnpinFrame ();
+
+    I_ProfileStage(PROF_OTHER);
 }
 
 
@@ -72,6 +72,17 @@ extern int16_t   __far* textureheight; //needed for texture pegging (and TFE fix
 
 extern int16_t       __far* texturetranslation;
 
+extern boolean viewanimated; // an animated flat or texture has been drawn
+
+#if defined VARIABLE_DETAIL
+extern int16_t detailshift; // 0 = high, 1 = medium, 2 = low detail
+extern int16_t viewwindowwidth;
+#define xtoviewangle(x) xtoviewangleTable[(x) << detailshift]
+#else
+#define viewwindowwidth VIEWWINDOWWIDTH
+#define xtoviewangle(x) xtoviewangleTable[x]
+#endif
+
 
 //
 // Utility functions.
@@ -82,6 +93,9 @@ angle_t R_PointToAngle3(fixed_t x, fixed_t y);
 subsector_t __far* R_PointInSubsector(fixed_t x, fixed_t y);
 
 void R_InitColormaps(void);
+void R_InitColumnCache(void);
+void R_GetColumnCacheStats(uint32_t* hits, uint32_t* misses);
+void R_InitPVS(const mappvs_t __far* data);
 const uint8_t* R_LoadColorMap(int16_t lightlevel);
 
 int16_t V_NumPatchWidth(int16_t num);
@@ -93,9 +107,20 @@ int16_t V_NumPatchWidth(int16_t num);
 
 void R_RenderPlayerView(player_t *player);   // Called by G_Drawer.
 
+boolean R_IsViewUnchanged(const player_t *player);
+void R_InvalidateView(void);
+void R_InvalidateAnimation(void);
+void R_InvalidateSector(const sector_t __far* sector);
+void R_InvalidateMobj(const mobj_t __far* mobj);
+
+#if defined VARIABLE_DETAIL
+void R_SetDetail(int16_t shift);
+#endif
+
 void R_DrawColumnSprite(const draw_column_vars_t *dcvars);
 void R_DrawColumnWall(const draw_column_vars_t *dcvars);
 void R_DrawColumnFlat(uint8_t color, const draw_column_vars_t *dcvars);
+void R_DrawSpanFlat(uint8_t color, int16_t y, int16_t x1, int16_t x2);
 
 void R_DrawPlanes (void);
 visplane_t __far* R_FindPlane(fixed_t height, int16_t picnum, int16_t lightlevel);
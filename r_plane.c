@@ -70,7 +70,10 @@ byte R_GetPlaneColor(int16_t picnum, int16_t lightlevel)
 	const uint8_t* colormap = R_LoadColorMap(lightlevel);
 
 	if (picnum == -3)
+	{
 		picnum = nukage;
+		viewanimated = true;
+	}
 
 	return colormap[picnum];
 }
@@ -109,7 +112,11 @@ static fixed_t yslope(uint8_t y)
 
 static fixed_t distscale(uint8_t x)
 {
+#if defined VARIABLE_DETAIL
+	return 0x010000 | distscaleTable[x << detailshift];
+#else
 	return 0x010000 | distscaleTable[x];
+#endif
 }
 
 
@@ -119,7 +126,7 @@ static void R_MapPlane(uint16_t y, uint16_t x1, uint16_t x2, draw_span_vars_t *d
     dsvars->step = ((FixedMul(distance,basexscale) << 10) & 0xffff0000) | ((FixedMul(distance,baseyscale) >> 6) & 0x0000ffff);
 
     fixed_t length = FixedMul (distance, distscale(x1));
-    int16_t angle = (viewangle + (((angle_t)xtoviewangleTable[x1]) << FRACBITS)) >> ANGLETOFINESHIFT;
+    int16_t angle = (viewangle + (((angle_t)xtoviewangle(x1)) << FRACBITS)) >> ANGLETOFINESHIFT;
 
     // killough 2/28/98: Add offsets
     uint32_t xfrac =  viewx + FixedMulAngle(length, finecosineapprox(angle));
@@ -171,6 +178,9 @@ static void R_DoDrawPlane(visplane_t __far* pl)
 
             draw_span_vars_t dsvars;
 
+            if ((uint16_t)(pl->picnum - animated_flat_basepic) < 3)
+                viewanimated = true;
+
             dsvars.source   = W_GetLumpByNum(firstflat + flattranslation[pl->picnum]);
             dsvars.colormap = R_LoadColorMap(pl->lightlevel);
 
@@ -194,7 +204,11 @@ static void R_DoDrawPlane(visplane_t __far* pl)
 
 void R_DrawPlanes (void)
 {
+#if defined VARIABLE_DETAIL
+    const fixed_t iprojection = (1L << FRACBITS) / (viewwindowwidth / 2);
+#else
     static const fixed_t iprojection = (1L << FRACBITS) / (VIEWWINDOWWIDTH / 2);
+#endif
 
     basexscale = FixedMul(viewsin,iprojection);
     baseyscale = FixedMul(viewcos,iprojection);
@@ -289,7 +303,7 @@ visplane_t __far* R_FindPlane(fixed_t height, int16_t picnum, int16_t lightlevel
     check->height = height;
     check->picnum = picnum;
     check->lightlevel = lightlevel;
-    check->minx = VIEWWINDOWWIDTH;
+    check->minx = viewwindowwidth;
     check->maxx = -1;
 
     _fmemset(check->top, -1, sizeof(check->top));
@@ -82,7 +82,7 @@ void R_DrawSky(draw_column_vars_t *dcvars)
 		dcvars->fracstep = ((FRACUNIT * SCREENHEIGHT_VGA) / (VIEWWINDOWHEIGHT + 16)) >> COLEXTRABITS;
 
 		int16_t xc = viewangle >> FRACBITS;
-		xc += xtoviewangleTable[dcvars->x];
+		xc += xtoviewangle(dcvars->x);
 		xc >>= ANGLETOSKYSHIFT - FRACBITS;
 		xc &= skywidthmask;
 
@@ -139,7 +139,7 @@ void R_DrawSky(visplane_t __far* pl)
 		if ((dcvars.yl = pl->top[x]) != -1 && dcvars.yl <= (dcvars.yh = pl->bottom[x])) // dropoff overflow
 		{
 			int16_t xc = viewangle >> FRACBITS;
-			xc += xtoviewangleTable[x];
+			xc += xtoviewangle(x);
 			xc >>= ANGLETOSKYSHIFT - FRACBITS;
 			xc &= skywidthmask;
 
@@ -0,0 +1,944 @@
+/*-----------------------------------------------------------------------------
+ *
+ *
+ *  Copyright (C) 2026 Frenkel Smeijers
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ *  02111-1307, USA.
+ *
+ * DESCRIPTION:
+ *      Host tool that computes a potentially visible set per subsector
+ *      and stores it in an extra lump per map, E1M1PVS for E1M1 etc.
+ *      The subsectors are convex polygons that are connected
+ *      by portals: the parts of their edges that aren't one-sided walls.
+ *      Like Quake's vis, light is flowed through chains of portals
+ *      in 2D. Heights are ignored, so closed doors count as open.
+ *      Usage: mappvs DOOM1.WAD DOOM1P.WAD
+ *
+ *-----------------------------------------------------------------------------*/
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wadfile.h"
+
+
+#define NF_SUBSECTOR	0x8000
+#define NO_INDEX8	0xff
+
+
+// Lump order in a map WAD, the same as in p_setup.c
+enum {
+	ML_LABEL,
+	ML_THINGS,
+	ML_LINEDEFS,
+	ML_SIDEDEFS,
+	ML_SEGS,
+	ML_SSECTORS,
+	ML_NODES,
+	ML_SECTORS,
+	ML_REJECT,
+	ML_BLOCKMAP,
+	ML_COUNT
+};
+
+
+// The map lumps have been preprocessed by jWadUtil
+#define SEG_SIZE	18
+#define NODE_SIZE	28
+
+#define WORLD_SIZE	65536.0
+
+// All epsilons favour seeing too much over seeing too little
+#define ON_EPSILON	0.1	// distance to a line that counts as on the line
+#define EDGE_EPSILON	1.0	// distance between edges of neighbouring subsectors
+#define MIN_PORTAL	0.01	// shortest portal
+
+#define MAX_STEPS	(1L << 22)	// portal flow steps before giving up
+
+
+typedef struct
+{
+	double x, y;
+} vec2_t;
+
+typedef struct
+{
+	int numpoints;
+	vec2_t *points;
+} polygon_t;
+
+typedef struct
+{
+	vec2_t normal;	// points into the leaf on the other side
+	double dist;
+} plane_t;
+
+typedef struct
+{
+	vec2_t p[2];
+	plane_t plane;
+	int leaf;	// the leaf on the other side
+	int numsteps;	// flow steps through this portal, to sort by
+	uint8_t *mightsee;
+	uint8_t *vis;
+} portal_t;
+
+typedef struct
+{
+	polygon_t polygon;
+	int numportals;
+	int *portals;
+} leaf_t;
+
+
+static int numleaves;
+static int rowsize;
+static leaf_t *leaves;
+
+static int numportals;
+static int maxportals;
+static portal_t *portals;
+
+static const uint8_t *segs;
+static int *firstsegs;
+static const uint8_t *subsectors;
+
+
+static int16_t readInt16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+
+static void writeInt16(uint8_t *p, int16_t value)
+{
+	p[0] = value;
+	p[1] = value >> 8;
+}
+
+
+static int isMapLabel(const wadfile_t *wad, int i)
+{
+	const char *name = wad->lumps[i].name;
+
+	if (i + ML_COUNT > wad->numlumps || strncmp(wad->lumps[i + ML_THINGS].name, "THINGS", 8))
+		return 0;
+
+	return (name[0] == 'E' && isdigit(name[1]) && name[2] == 'M' && isdigit(name[3]) && !name[4])
+	    || (!strncmp(name, "MAP", 3) && isdigit(name[3]) && isdigit(name[4]) && !name[5]);
+}
+
+
+static double dot(vec2_t a, vec2_t b)
+{
+	return a.x * b.x + a.y * b.y;
+}
+
+
+static vec2_t lerp(vec2_t a, vec2_t b, double t)
+{
+	vec2_t r = {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t};
+	return r;
+}
+
+
+static double length(vec2_t a, vec2_t b)
+{
+	return hypot(b.x - a.x, b.y - a.y);
+}
+
+
+// The plane through a and b, with its normal to the left of a->b
+static int makePlane(plane_t *plane, vec2_t a, vec2_t b)
+{
+	double l = length(a, b);
+	if (l < MIN_PORTAL)
+	{
+		plane->normal.x = plane->normal.y = plane->dist = 0;
+		return 0;
+	}
+
+	plane->normal.x = -(b.y - a.y) / l;
+	plane->normal.y =  (b.x - a.x) / l;
+	plane->dist     = dot(plane->normal, a);
+	return 1;
+}
+
+
+static double planeDist(const plane_t *plane, vec2_t p)
+{
+	return dot(plane->normal, p) - plane->dist;
+}
+
+
+//
+// Polygons
+//
+
+// Keeps the part of the polygon in front of the plane
+static void clipPolygon(polygon_t *polygon, const plane_t *plane, double epsilon)
+{
+	int n = polygon->numpoints;
+	vec2_t *points = malloc((n * 2 + 1) * sizeof(vec2_t));
+	int numpoints = 0;
+
+	for (int i = 0; i < n; i++)
+	{
+		vec2_t a = polygon->points[i];
+		vec2_t b = polygon->points[(i + 1) % n];
+		double da = planeDist(plane, a);
+		double db = planeDist(plane, b);
+
+		if (da >= -epsilon)
+			points[numpoints++] = a;
+
+		if ((da < -epsilon && db > epsilon) || (da > epsilon && db < -epsilon))
+			points[numpoints++] = lerp(a, b, da / (da - db));
+	}
+
+	free(polygon->points);
+	polygon->points    = points;
+	polygon->numpoints = numpoints;
+}
+
+
+static void copyPolygon(polygon_t *dest, const polygon_t *src)
+{
+	dest->numpoints = src->numpoints;
+	dest->points    = malloc((src->numpoints ? src->numpoints : 1) * sizeof(vec2_t));
+	memcpy(dest->points, src->points, src->numpoints * sizeof(vec2_t));
+}
+
+
+// The front side of a node and of a seg is the right side
+static void segPlane(plane_t *plane, const uint8_t *seg)
+{
+	vec2_t v1 = {readInt16(&seg[0]), readInt16(&seg[2])};
+	vec2_t v2 = {readInt16(&seg[4]), readInt16(&seg[6])};
+	makePlane(plane, v2, v1);
+}
+
+
+static void makeLeafPolygon(int leaf, const polygon_t *polygon)
+{
+	polygon_t *p = &leaves[leaf].polygon;
+	copyPolygon(p, polygon);
+
+	// the subsector lies in front of all its segs
+	for (int i = 0; i < subsectors[leaf]; i++)
+	{
+		plane_t plane;
+		segPlane(&plane, &segs[(firstsegs[leaf] + i) * SEG_SIZE]);
+		if (plane.normal.x == 0 && plane.normal.y == 0)
+			continue;
+
+		polygon_t clipped;
+		copyPolygon(&clipped, p);
+		clipPolygon(&clipped, &plane, ON_EPSILON);
+
+		// node builders round vertices, don't let that empty the polygon
+		if (clipped.numpoints >= 3)
+		{
+			free(p->points);
+			*p = clipped;
+		}
+		else
+			free(clipped.points);
+	}
+}
+
+
+static void makeLeafPolygons(const uint8_t *nodes, uint16_t bspnum, const polygon_t *polygon)
+{
+	if (bspnum & NF_SUBSECTOR)
+	{
+		int leaf = bspnum == 0xffff ? 0 : bspnum & ~NF_SUBSECTOR;
+		if (leaf < numleaves && leaves[leaf].polygon.numpoints == 0)
+			makeLeafPolygon(leaf, polygon);
+		return;
+	}
+
+	const uint8_t *node = &nodes[bspnum * NODE_SIZE];
+	vec2_t a = {readInt16(&node[0]), readInt16(&node[2])};
+	vec2_t b = {a.x + readInt16(&node[4]), a.y + readInt16(&node[6])};
+
+	plane_t plane;
+	if (!makePlane(&plane, b, a))
+		return;
+
+	for (int side = 0; side < 2; side++)
+	{
+		polygon_t child;
+		copyPolygon(&child, polygon);
+		clipPolygon(&child, &plane, 0);
+
+		if (child.numpoints >= 3)
+			makeLeafPolygons(nodes, readInt16(&node[24 + side * 2]), &child);
+
+		free(child.points);
+
+		plane.normal.x = -plane.normal.x;
+		plane.normal.y = -plane.normal.y;
+		plane.dist     = -plane.dist;
+	}
+}
+
+
+//
+// Portals
+//
+
+static void addPortal(int from, int to, vec2_t a, vec2_t b)
+{
+	if (numportals == maxportals)
+	{
+		maxportals = maxportals ? 2 * maxportals : 256;
+		portals    = realloc(portals, maxportals * sizeof(portal_t));
+		if (!portals)
+		{
+			printf("Out of memory for %d portals\n", maxportals);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	portal_t *portal = &portals[numportals];
+
+	// a->b runs clockwise around from, so to is on the left
+	portal->p[0] = a;
+	portal->p[1] = b;
+	makePlane(&portal->plane, a, b);
+	portal->leaf     = to;
+	portal->numsteps = 0;
+	portal->mightsee = calloc(rowsize, 1);
+	portal->vis      = calloc(rowsize, 1);
+
+	leaf_t *leaf = &leaves[from];
+	leaf->portals = realloc(leaf->portals, (leaf->numportals + 1) * sizeof(int));
+	leaf->portals[leaf->numportals++] = numportals++;
+}
+
+
+// Removes the parts of the interval [t0, t1] along a->b
+// that are covered by one-sided segs of a leaf
+static int subtractWalls(int leaf, vec2_t a, vec2_t b, double l, double *intervals, int numintervals)
+{
+	vec2_t dir = {(b.x - a.x) / l, (b.y - a.y) / l};
+	plane_t plane;
+	makePlane(&plane, a, b);
+
+	for (int i = 0; i < subsectors[leaf]; i++)
+	{
+		const uint8_t *seg = &segs[(firstsegs[leaf] + i) * SEG_SIZE];
+		if (seg[17] != NO_INDEX8)
+			continue;
+
+		vec2_t v1 = {readInt16(&seg[0]), readInt16(&seg[2])};
+		vec2_t v2 = {readInt16(&seg[4]), readInt16(&seg[6])};
+		if (fabs(planeDist(&plane, v1)) > EDGE_EPSILON || fabs(planeDist(&plane, v2)) > EDGE_EPSILON)
+			continue;
+
+		vec2_t d1 = {v1.x - a.x, v1.y - a.y};
+		vec2_t d2 = {v2.x - a.x, v2.y - a.y};
+		double s1 = dot(d1, dir);
+		double s2 = dot(d2, dir);
+		double w0 = s1 < s2 ? s1 : s2;
+		double w1 = s1 < s2 ? s2 : s1;
+
+		int n = 0;
+		double result[64];
+		for (int j = 0; j < numintervals; j++)
+		{
+			double i0 = intervals[j * 2];
+			double i1 = intervals[j * 2 + 1];
+
+			if (w1 <= i0 || w0 >= i1)
+			{
+				result[n++] = i0;
+				result[n++] = i1;
+				continue;
+			}
+
+			if (w0 > i0 && n < 62)
+			{
+				result[n++] = i0;
+				result[n++] = w0;
+			}
+
+			if (w1 < i1 && n < 62)
+			{
+				result[n++] = w1;
+				result[n++] = i1;
+			}
+		}
+
+		memcpy(intervals, result, n * sizeof(double));
+		numintervals = n / 2;
+	}
+
+	return numintervals;
+}
+
+
+// Two leaves are neighbours where their edges overlap in opposite directions
+static void findPortals(int l1, int l2)
+{
+	const polygon_t *p1 = &leaves[l1].polygon;
+	const polygon_t *p2 = &leaves[l2].polygon;
+
+	for (int i = 0; i < p1->numpoints; i++)
+	{
+		vec2_t a = p1->points[i];
+		vec2_t b = p1->points[(i + 1) % p1->numpoints];
+		double l = length(a, b);
+		if (l < MIN_PORTAL)
+			continue;
+
+		plane_t plane;
+		makePlane(&plane, a, b);
+		vec2_t dir = {(b.x - a.x) / l, (b.y - a.y) / l};
+
+		for (int j = 0; j < p2->numpoints; j++)
+		{
+			vec2_t c = p2->points[j];
+			vec2_t d = p2->points[(j + 1) % p2->numpoints];
+
+			if (fabs(planeDist(&plane, c)) > EDGE_EPSILON || fabs(planeDist(&plane, d)) > EDGE_EPSILON)
+				continue;
+
+			vec2_t dc = {c.x - a.x, c.y - a.y};
+			vec2_t dd = {d.x - a.x, d.y - a.y};
+			double sc = dot(dc, dir);
+			double sd = dot(dd, dir);
+			if (sd >= sc)
+				continue;	// same direction
+
+			double t0 = sd > 0 ? sd : 0;
+			double t1 = sc < l ? sc : l;
+			if (t1 - t0 < MIN_PORTAL)
+				continue;
+
+			double intervals[64] = {t0, t1};
+			int numintervals = subtractWalls(l1, a, b, l, intervals, 1);
+			numintervals     = subtractWalls(l2, a, b, l, intervals, numintervals);
+
+			for (int k = 0; k < numintervals; k++)
+			{
+				if (intervals[k * 2 + 1] - intervals[k * 2] < MIN_PORTAL)
+					continue;
+
+				vec2_t pa = lerp(a, b, intervals[k * 2]     / l);
+				vec2_t pb = lerp(a, b, intervals[k * 2 + 1] / l);
+				addPortal(l1, l2, pa, pb);
+				addPortal(l2, l1, pb, pa);
+			}
+		}
+	}
+}
+
+
+static void polygonBox(const polygon_t *polygon, double *box)
+{
+	box[0] = box[1] =  WORLD_SIZE;
+	box[2] = box[3] = -WORLD_SIZE;
+
+	for (int i = 0; i < polygon->numpoints; i++)
+	{
+		vec2_t p = polygon->points[i];
+		if (p.x < box[0]) box[0] = p.x;
+		if (p.y < box[1]) box[1] = p.y;
+		if (p.x > box[2]) box[2] = p.x;
+		if (p.y > box[3]) box[3] = p.y;
+	}
+}
+
+
+static void makePortals(void)
+{
+	double *boxes = malloc(numleaves * 4 * sizeof(double));
+	for (int i = 0; i < numleaves; i++)
+		polygonBox(&leaves[i].polygon, &boxes[i * 4]);
+
+	for (int i = 0; i < numleaves; i++)
+	{
+		const double *b1 = &boxes[i * 4];
+		for (int j = i + 1; j < numleaves; j++)
+		{
+			const double *b2 = &boxes[j * 4];
+			if (b1[0] > b2[2] + EDGE_EPSILON || b2[0] > b1[2] + EDGE_EPSILON
+			 || b1[1] > b2[3] + EDGE_EPSILON || b2[1] > b1[3] + EDGE_EPSILON)
+				continue;
+
+			findPortals(i, j);
+		}
+	}
+
+	free(boxes);
+}
+
+
+//
+// Portal flow
+//
+
+#define TESTBIT(row, n)	((row)[(n) >> 3] & (1 << ((n) & 7)))
+#define SETBIT(row, n)	((row)[(n) >> 3] |= (1 << ((n) & 7)))
+
+
+// Flood fill through the portals that are in front of the portal
+static void simpleFlood(const portal_t *portal, int leaf, const uint8_t *infront)
+{
+	if (TESTBIT(portal->mightsee, leaf))
+		return;
+
+	SETBIT(portal->mightsee, leaf);
+
+	for (int i = 0; i < leaves[leaf].numportals; i++)
+	{
+		int p = leaves[leaf].portals[i];
+		if (TESTBIT(infront, p))
+			simpleFlood(portal, portals[p].leaf, infront);
+	}
+}
+
+
+static void basePortalVis(int p)
+{
+	portal_t *portal = &portals[p];
+	uint8_t *infront = calloc((numportals + 7) / 8, 1);
+
+	for (int q = 0; q < numportals; q++)
+	{
+		const portal_t *target = &portals[q];
+		if (q == p)
+			continue;
+
+		// the target has to be partly in front of the portal
+		if (planeDist(&portal->plane, target->p[0]) <= ON_EPSILON
+		 && planeDist(&portal->plane, target->p[1]) <= ON_EPSILON)
+			continue;
+
+		// and the portal partly behind the target
+		if (planeDist(&target->plane, portal->p[0]) >= -ON_EPSILON
+		 && planeDist(&target->plane, portal->p[1]) >= -ON_EPSILON)
+			continue;
+
+		SETBIT(infront, q);
+	}
+
+	simpleFlood(portal, portal->leaf, infront);
+	free(infront);
+}
+
+
+// Keeps the part of the segment in front of the plane
+static int chopSegment(vec2_t *s, const plane_t *plane)
+{
+	double d0 = planeDist(plane, s[0]);
+	double d1 = planeDist(plane, s[1]);
+
+	if (d0 < -ON_EPSILON && d1 < -ON_EPSILON)
+		return 0;
+
+	if (d0 < -ON_EPSILON && d1 > 0)
+		s[0] = lerp(s[0], s[1], d0 / (d0 - d1));
+	else if (d1 < -ON_EPSILON && d0 > 0)
+		s[1] = lerp(s[0], s[1], d0 / (d0 - d1));
+
+	return 1;
+}
+
+
+// Keeps the part of the target that can be seen from the source through the pass.
+// In 2D the separators are the two lines through an end of the source
+// and an end of the pass that have the source and the pass on opposite sides.
+static int clipToSeparators(const vec2_t *source, const vec2_t *pass, vec2_t *target)
+{
+	for (int i = 0; i < 2; i++)
+	{
+		for (int j = 0; j < 2; j++)
+		{
+			plane_t plane;
+			if (!makePlane(&plane, source[i], pass[j]))
+				continue;
+
+			double ds = planeDist(&plane, source[i ^ 1]);
+			double dp = planeDist(&plane, pass[j ^ 1]);
+
+			if (fabs(ds) < ON_EPSILON || fabs(dp) < ON_EPSILON || (ds < 0) == (dp < 0))
+				continue;
+
+			// keep the side of the pass
+			if (dp < 0)
+			{
+				plane.normal.x = -plane.normal.x;
+				plane.normal.y = -plane.normal.y;
+				plane.dist     = -plane.dist;
+			}
+
+			if (!chopSegment(target, &plane))
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+
+typedef struct pstack_s
+{
+	const struct pstack_s *prev;
+	int leaf;
+	const portal_t *portal;
+	vec2_t source[2];
+	vec2_t pass[2];
+	int haspass;
+	uint8_t *mightsee;
+} pstack_t;
+
+
+static long numsteps;
+
+
+static void recursiveLeafFlow(portal_t *base, const pstack_t *prevstack)
+{
+	int leafnum = prevstack->leaf;
+	SETBIT(base->vis, leafnum);
+
+	if (numsteps >= MAX_STEPS)
+		return;
+
+	const leaf_t *leaf = &leaves[leafnum];
+	uint8_t *might = malloc(rowsize);
+
+	for (int i = 0; i < leaf->numportals; i++)
+	{
+		const portal_t *portal = &portals[leaf->portals[i]];
+
+		if (!TESTBIT(prevstack->mightsee, portal->leaf))
+			continue;	// can't possibly see it
+
+		// light never goes through a convex leaf twice
+		const pstack_t *s;
+		for (s = prevstack; s; s = s->prev)
+		{
+			if (s->leaf == portal->leaf)
+				break;
+		}
+		if (s)
+			continue;
+
+		// if the portal can't see anything we haven't already seen, skip it
+		const uint8_t *test = portal->numsteps ? portal->vis : portal->mightsee;
+		int more = 0;
+		for (int j = 0; j < rowsize; j++)
+		{
+			might[j] = prevstack->mightsee[j] & test[j];
+			more |= might[j] & ~base->vis[j];
+		}
+
+		if (!more && TESTBIT(base->vis, portal->leaf))
+			continue;
+
+		numsteps++;
+
+		pstack_t stack;
+		stack.prev     = prevstack;
+		stack.leaf     = portal->leaf;
+		stack.portal   = portal;
+		stack.mightsee = might;
+		stack.haspass  = 1;
+		memcpy(stack.pass,   portal->p,          sizeof(stack.pass));
+		memcpy(stack.source, prevstack->source, sizeof(stack.source));
+
+		// the pass has to be in front of the base portal
+		if (!chopSegment(stack.pass, &base->plane))
+			continue;
+
+		// and the source behind this portal
+		plane_t backplane = {{-portal->plane.normal.x, -portal->plane.normal.y}, -portal->plane.dist};
+		if (!chopSegment(stack.source, &backplane))
+			continue;
+
+		// the second leaf can only be blocked if it's on the same line
+		if (!prevstack->haspass)
+		{
+			recursiveLeafFlow(base, &stack);
+			continue;
+		}
+
+		if (!chopSegment(stack.pass, &prevstack->portal->plane))
+			continue;
+
+		if (!clipToSeparators(stack.source, prevstack->pass, stack.pass))
+			continue;
+
+		if (!clipToSeparators(stack.pass, prevstack->pass, stack.source))
+			continue;
+
+		recursiveLeafFlow(base, &stack);
+	}
+
+	free(might);
+}
+
+
+static int countBits(const uint8_t *row)
+{
+	int count = 0;
+	for (int i = 0; i < numleaves; i++)
+	{
+		if (TESTBIT(row, i))
+			count++;
+	}
+
+	return count;
+}
+
+
+static int compareMightsee(const void *a, const void *b)
+{
+	return countBits(portals[*(const int *)a].mightsee) - countBits(portals[*(const int *)b].mightsee);
+}
+
+
+static void portalFlow(void)
+{
+	for (int p = 0; p < numportals; p++)
+		basePortalVis(p);
+
+	// the portals that see the least go first,
+	// so their vis can prune the flow of the others
+	int *order = malloc(numportals * sizeof(int));
+	for (int p = 0; p < numportals; p++)
+		order[p] = p;
+
+	qsort(order, numportals, sizeof(int), compareMightsee);
+
+	for (int i = 0; i < numportals; i++)
+	{
+		portal_t *portal = &portals[order[i]];
+
+		pstack_t stack;
+		stack.prev     = NULL;
+		stack.leaf     = portal->leaf;
+		stack.portal   = portal;
+		stack.haspass  = 0;
+		stack.mightsee = portal->mightsee;
+		memcpy(stack.source, portal->p, sizeof(stack.source));
+
+		numsteps = 0;
+		recursiveLeafFlow(portal, &stack);
+
+		if (numsteps >= MAX_STEPS)
+			memcpy(portal->vis, portal->mightsee, rowsize);
+
+		portal->numsteps = numsteps ? numsteps : 1;
+	}
+
+	free(order);
+}
+
+
+//
+// Compressing the rows
+//
+
+// Runs of zero bytes are stored as a zero followed by the length of the run
+static int compressRow(const uint8_t *row, uint8_t *dest)
+{
+	int d = 0;
+
+	for (int i = 0; i < rowsize; i++)
+	{
+		dest[d++] = row[i];
+		if (row[i])
+			continue;
+
+		int run = 1;
+		while (i + 1 < rowsize && !row[i + 1] && run < 255)
+		{
+			i++;
+			run++;
+		}
+		dest[d++] = run;
+	}
+
+	return d;
+}
+
+
+static void makePVS(wadfile_t *wad, int label)
+{
+	const lump_t *lumps = &wad->lumps[label];
+
+	for (int ml = ML_SEGS; ml <= ML_NODES; ml++)
+	{
+		if (lumps[ml].compressedsize)
+		{
+			printf("%.8s: run mappvs before wadcomp\n", lumps[ML_LABEL].name);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	segs       = lumps[ML_SEGS].data;
+	subsectors = lumps[ML_SSECTORS].data;
+
+	const uint8_t *nodes = lumps[ML_NODES].data;
+	int numnodes = lumps[ML_NODES].size / NODE_SIZE;
+
+	numleaves = lumps[ML_SSECTORS].size;
+	rowsize   = (numleaves + 7) / 8;
+	leaves    = calloc(numleaves, sizeof(leaf_t));
+	firstsegs = malloc(numleaves * sizeof(int));
+
+	for (int i = 0, firstseg = 0; i < numleaves; i++)
+	{
+		firstsegs[i] = firstseg;
+		firstseg += subsectors[i];
+	}
+
+	vec2_t world[4] = {{-WORLD_SIZE, -WORLD_SIZE}, {-WORLD_SIZE, WORLD_SIZE}, {WORLD_SIZE, WORLD_SIZE}, {WORLD_SIZE, -WORLD_SIZE}};
+	polygon_t polygon = {4, world};
+	makeLeafPolygons(nodes, numnodes ? numnodes - 1 : 0xffff, &polygon);
+
+	// addPortal grows the array
+	numportals = 0;
+	maxportals = 0;
+	portals    = NULL;
+	makePortals();
+	portalFlow();
+
+	uint8_t **rows = malloc(numleaves * sizeof(uint8_t *));
+	for (int i = 0; i < numleaves; i++)
+	{
+		rows[i] = calloc(rowsize, 1);
+		SETBIT(rows[i], i);
+
+		for (int j = 0; j < leaves[i].numportals; j++)
+		{
+			const portal_t *portal = &portals[leaves[i].portals[j]];
+			for (int k = 0; k < rowsize; k++)
+				rows[i][k] |= portal->vis[k];
+		}
+	}
+
+	// a leaf without a polygon can see, and be seen by, everything
+	int degenerate = 0;
+	for (int i = 0; i < numleaves; i++)
+	{
+		if (leaves[i].polygon.numpoints >= 3)
+			continue;
+
+		degenerate++;
+		for (int j = 0; j < numleaves; j++)
+		{
+			SETBIT(rows[i], j);
+			SETBIT(rows[j], i);
+		}
+	}
+
+	// header, offsets and the worst case of the compressed rows
+	uint32_t size = 4 + numleaves * 2;
+	uint8_t *data = malloc(size + numleaves * (rowsize + rowsize / 2 + 2));
+	writeInt16(&data[0], numleaves);
+	writeInt16(&data[2], numnodes);
+
+	long totalvisible = 0;
+	for (int i = 0; i < numleaves; i++)
+	{
+		writeInt16(&data[4 + i * 2], size);
+		size += compressRow(rows[i], &data[size]);
+		totalvisible += countBits(rows[i]);
+	}
+
+	char name[9];
+	snprintf(name, sizeof(name), "%.5sPVS", lumps[ML_LABEL].name);
+
+	if (size > 0xffff)
+		printf("%-8.8s too large\n", name);
+	else
+	{
+		// after the map lumps and the topology lump
+		char topname[9];
+		snprintf(topname, sizeof(topname), "%.5sTOP", lumps[ML_LABEL].name);
+
+		int num = WAD_FindLump(wad, name);
+		if (num == -1)
+		{
+			num = WAD_FindLump(wad, topname);
+			num = num == -1 ? label + ML_COUNT : num + 1;
+		}
+
+		lump_t *lump = num < wad->numlumps && !strncmp(wad->lumps[num].name, name, 8)
+		             ? &wad->lumps[num]
+		             : WAD_InsertLump(wad, num, name);
+		WAD_SetLumpData(lump, data, size);
+
+		printf("%-8.8s %5d subsectors %5d portals %5.1f%% visible %6u bytes", name, numleaves, numportals / 2, numleaves ? 100.0 * totalvisible / ((double)numleaves * numleaves) : 0, size);
+		if (degenerate)
+			printf(" %d degenerate", degenerate);
+		printf("\n");
+	}
+
+	free(data);
+
+	for (int i = 0; i < numleaves; i++)
+	{
+		free(rows[i]);
+		free(leaves[i].polygon.points);
+		free(leaves[i].portals);
+	}
+	free(rows);
+
+	for (int i = 0; i < numportals; i++)
+	{
+		free(portals[i].mightsee);
+		free(portals[i].vis);
+	}
+	free(portals);
+
+	free(firstsegs);
+	free(leaves);
+}
+
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3)
+	{
+		printf("Usage: %s input.wad output.wad\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	wadfile_t wad;
+	if (!WAD_Read(&wad, argv[1]))
+		return EXIT_FAILURE;
+
+	for (int i = 0; i < wad.numlumps; i++)
+	{
+		if (isMapLabel(&wad, i))
+			makePVS(&wad, i);
+	}
+
+	if (!WAD_Write(&wad, argv[2], NULL))
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
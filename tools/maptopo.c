@@ -0,0 +1,299 @@
+/*-----------------------------------------------------------------------------
+ *
+ *
+ *  Copyright (C) 2026 Frenkel Smeijers
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ *  02111-1307, USA.
+ *
+ * DESCRIPTION:
+ *      Host tool that prebakes what P_GroupLines computes
+ *      into an extra lump per map, E1M1TOP for E1M1 etc.
+ *      Usage: maptopo DOOM1.WAD DOOM1T.WAD
+ *
+ *-----------------------------------------------------------------------------*/
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wadfile.h"
+
+
+#define NO_INDEX	((uint16_t)-1)
+
+#define FRACBITS	16
+
+
+// Lump order in a map WAD, the same as in p_setup.c
+enum {
+	ML_LABEL,
+	ML_THINGS,
+	ML_LINEDEFS,
+	ML_SIDEDEFS,
+	ML_SEGS,
+	ML_SSECTORS,
+	ML_NODES,
+	ML_SECTORS,
+	ML_REJECT,
+	ML_BLOCKMAP,
+	ML_COUNT
+};
+
+enum
+{
+	BOXTOP,
+	BOXBOTTOM,
+	BOXLEFT,
+	BOXRIGHT
+};
+
+
+// The map lumps have been preprocessed by jWadUtil
+#define LINEDEF_SIZE	15
+#define SIDEDEF_SIZE	7
+#define SEG_SIZE	18
+#define SECTOR_SIZE	12	// FLAT_SPAN layout, every build script sets FLAT_SPAN
+
+
+static int16_t readInt16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+
+static void writeInt16(uint8_t **p, int16_t value)
+{
+	*(*p)++ = value;
+	*(*p)++ = value >> 8;
+}
+
+
+static void writeInt32(uint8_t **p, int32_t value)
+{
+	writeInt16(p, value);
+	writeInt16(p, value >> 16);
+}
+
+
+static void clearBox(int32_t *box)
+{
+	box[BOXTOP]    = box[BOXRIGHT] = INT32_MIN;
+	box[BOXBOTTOM] = box[BOXLEFT]  = INT32_MAX;
+}
+
+
+// Same as M_AddToBox in p_setup.c, including the else ifs
+static void addToBox(int32_t *box, int32_t x, int32_t y)
+{
+	if (x < box[BOXLEFT])
+		box[BOXLEFT]  = x;
+	else if (x > box[BOXRIGHT])
+		box[BOXRIGHT] = x;
+
+	if (y < box[BOXBOTTOM])
+		box[BOXBOTTOM] = y;
+	else if (y > box[BOXTOP])
+		box[BOXTOP]    = y;
+}
+
+
+static int isMapLabel(const wadfile_t *wad, int i)
+{
+	const char *name = wad->lumps[i].name;
+
+	if (i + ML_COUNT > wad->numlumps || strncmp(wad->lumps[i + ML_THINGS].name, "THINGS", 8))
+		return 0;
+
+	return (name[0] == 'E' && isdigit(name[1]) && name[2] == 'M' && isdigit(name[3]) && !name[4])
+	    || (!strncmp(name, "MAP", 3) && isdigit(name[3]) && isdigit(name[4]) && !name[5]);
+}
+
+
+// Does what P_GroupLines does
+static void makeTopology(wadfile_t *wad, int label)
+{
+	const lump_t *lumps = &wad->lumps[label];
+
+	for (int ml = ML_LINEDEFS; ml <= ML_SECTORS; ml++)
+	{
+		if (lumps[ml].compressedsize)
+		{
+			printf("%.8s: run maptopo before wadcomp\n", lumps[ML_LABEL].name);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (lumps[ML_SECTORS].size % SECTOR_SIZE)
+	{
+		printf("%.8s: sector lump is not a multiple of %d bytes, only the FLAT_SPAN format is supported\n", lumps[ML_LABEL].name, SECTOR_SIZE);
+		exit(EXIT_FAILURE);
+	}
+
+	const uint8_t *linedefs   = lumps[ML_LINEDEFS].data;
+	const uint8_t *sidedefs   = lumps[ML_SIDEDEFS].data;
+	const uint8_t *segs       = lumps[ML_SEGS].data;
+	const uint8_t *subsectors = lumps[ML_SSECTORS].data;
+
+	int numlines      = lumps[ML_LINEDEFS].size / LINEDEF_SIZE;
+	int numsubsectors = lumps[ML_SSECTORS].size;
+	int numsectors    = lumps[ML_SECTORS].size / SECTOR_SIZE;
+
+	int16_t *subsectorsectors = malloc(numsubsectors * sizeof(int16_t));
+	int16_t *linecounts       = calloc(numsectors, sizeof(int16_t));
+	int16_t *firstlines       = malloc(numsectors * sizeof(int16_t));
+	int16_t *linenums         = malloc(2 * numlines * sizeof(int16_t));
+
+	int firstseg = 0;
+	for (int i = 0; i < numsubsectors; i++)
+	{
+		subsectorsectors[i] = -1;
+		for (int j = 0; j < subsectors[i]; j++)
+		{
+			uint16_t sidenum = readInt16(&segs[(firstseg + j) * SEG_SIZE + 12]);
+			if (sidenum != NO_INDEX)
+			{
+				subsectorsectors[i] = sidedefs[sidenum * SIDEDEF_SIZE + 6];
+				break;
+			}
+		}
+		firstseg += subsectors[i];
+	}
+
+	// count number of lines in each sector
+	int totallines = 0;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int i = 0; i < numlines; i++)
+		{
+			const uint8_t *line = &linedefs[i * LINEDEF_SIZE];
+			uint16_t frontsidenum = readInt16(&line[8]);
+			uint16_t backsidenum  = readInt16(&line[10]);
+
+			int front = sidedefs[frontsidenum * SIDEDEF_SIZE + 6];
+			int back  = backsidenum != NO_INDEX ? sidedefs[backsidenum * SIDEDEF_SIZE + 6] : -1;
+
+			if (pass == 0)
+			{
+				linecounts[front]++;
+				totallines++;
+				if (back != -1 && back != front)
+				{
+					linecounts[back]++;
+					totallines++;
+				}
+			}
+			else
+			{
+				// enter those lines
+				linenums[firstlines[front]++] = i;
+				if (back != -1 && back != front)
+					linenums[firstlines[back]++] = i;
+			}
+		}
+
+		if (pass == 0)
+		{
+			for (int i = 0, first = 0; i < numsectors; i++)
+			{
+				firstlines[i] = first;
+				first += linecounts[i];
+			}
+		}
+	}
+
+	uint32_t size = 8 + (numsubsectors + numsectors + totallines) * 2 + numsectors * 8;
+	uint8_t *data = malloc(size);
+	uint8_t *p    = data;
+
+	writeInt16(&p, numsubsectors);
+	writeInt16(&p, numsectors);
+	writeInt16(&p, numlines);
+	writeInt16(&p, totallines);
+
+	for (int i = 0; i < numsubsectors; i++)
+		writeInt16(&p, subsectorsectors[i]);
+
+	for (int i = 0; i < numsectors; i++)
+		writeInt16(&p, linecounts[i]);
+
+	for (int i = 0, first = 0; i < numsectors; i++)
+	{
+		int32_t bbox[4];
+		clearBox(bbox);
+
+		for (int l = first; l < first + linecounts[i]; l++)
+		{
+			const uint8_t *line = &linedefs[linenums[l] * LINEDEF_SIZE];
+			addToBox(bbox, (int32_t)readInt16(&line[0]) << FRACBITS, (int32_t)readInt16(&line[2]) << FRACBITS);
+			addToBox(bbox, (int32_t)readInt16(&line[4]) << FRACBITS, (int32_t)readInt16(&line[6]) << FRACBITS);
+		}
+
+		writeInt32(&p, bbox[BOXRIGHT] / 2 + bbox[BOXLEFT]   / 2);
+		writeInt32(&p, bbox[BOXTOP]   / 2 + bbox[BOXBOTTOM] / 2);
+
+		first += linecounts[i];
+	}
+
+	for (int i = 0; i < totallines; i++)
+		writeInt16(&p, linenums[i]);
+
+	char name[9];
+	snprintf(name, sizeof(name), "%.5sTOP", lumps[ML_LABEL].name);
+
+	int num = WAD_FindLump(wad, name);
+	if (num == -1)
+		num = label + ML_COUNT;
+
+	lump_t *lump = num < wad->numlumps && !strncmp(wad->lumps[num].name, name, 8)
+	             ? &wad->lumps[num]
+	             : WAD_InsertLump(wad, num, name);
+	WAD_SetLumpData(lump, data, size);
+
+	printf("%-8.8s %5d subsectors %4d sectors %5d lines %6u bytes\n", name, numsubsectors, numsectors, numlines, size);
+
+	free(data);
+	free(linenums);
+	free(firstlines);
+	free(linecounts);
+	free(subsectorsectors);
+}
+
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3)
+	{
+		printf("Usage: %s input.wad output.wad\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	wadfile_t wad;
+	if (!WAD_Read(&wad, argv[1]))
+		return EXIT_FAILURE;
+
+	for (int i = 0; i < wad.numlumps; i++)
+	{
+		if (isMapLabel(&wad, i))
+			makeTopology(&wad, i);
+	}
+
+	if (!WAD_Write(&wad, argv[2], NULL))
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,341 @@
+/*-----------------------------------------------------------------------------
+ *
+ *
+ *  Copyright (C) 2026 Frenkel Smeijers
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ *  02111-1307, USA.
+ *
+ * DESCRIPTION:
+ *      Host tool that merges the patches of every texture
+ *      with overlapping patches into a single patch,
+ *      so R_ComposeColumn is never needed.
+ *      The merged patches are named TEXM0000, TEXM0001 etc.
+ *      Usage: texmerge DOOM1.WAD DOOM1M.WAD
+ *
+ *-----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wadfile.h"
+
+
+// The TEXTURE1 and PNAMES formats of a preprocessed IWAD file,
+// the same as in r_data.c
+typedef struct
+{
+	int16_t originx;
+	int16_t originy;
+	int16_t patch;
+} mappatch_t;
+
+typedef struct
+{
+	char       name[8];
+	int16_t    width;
+	int16_t    height;
+	int16_t    patchcount;
+	mappatch_t patches[1];
+} maptexture_t;
+
+#define MAPTEXTURE_HEADERSIZE	(sizeof(maptexture_t) - sizeof(mappatch_t))
+
+
+static int16_t readInt16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+
+static int32_t readInt32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+static void writeInt16(uint8_t *p, int16_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+
+static void writeInt32(uint8_t *p, int32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+
+static lump_t *getLump(wadfile_t *wad, const char *name)
+{
+	int i = WAD_FindLump(wad, name);
+	if (i == -1)
+	{
+		printf("Lump %s not found\n", name);
+		exit(EXIT_FAILURE);
+	}
+
+	lump_t *lump = &wad->lumps[i];
+	if (lump->compressedsize)
+	{
+		printf("%.8s is compressed: run texmerge before wadcomp\n", lump->name);
+		exit(EXIT_FAILURE);
+	}
+
+	return lump;
+}
+
+
+static int16_t patchWidth(const lump_t *lump)
+{
+	return readInt16(lump->data);
+}
+
+
+// Same check as in R_LoadTexture
+static int isOverlapped(const maptexture_t *mtexture, lump_t *const *patches)
+{
+	for (int j = 0; j < mtexture->patchcount; j++)
+	{
+		int16_t l1 = mtexture->patches[j].originx;
+		int16_t r1 = l1 + patchWidth(patches[j]);
+
+		for (int k = j + 1; k < mtexture->patchcount; k++)
+		{
+			int16_t l2 = mtexture->patches[k].originx;
+			int16_t r2 = l2 + patchWidth(patches[k]);
+
+			if (r1 > l2 && l1 < r2)
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+// Same as R_DrawColumnInCache
+static void drawColumnInCache(const uint8_t *column, uint8_t *cache, int16_t originy, int16_t cacheheight)
+{
+	while (column[0] != 0xff)
+	{
+		const uint8_t *source = column + 3;
+		int16_t count = column[1];
+		int16_t position = originy + column[0];
+
+		if (position < 0)
+		{
+			source -= position;
+			count  += position;
+			position = 0;
+		}
+
+		if (position + count > cacheheight)
+			count = cacheheight - position;
+
+		if (count > 0)
+			memcpy(cache + position, source, count);
+
+		column += column[1] + 4;
+	}
+}
+
+
+// Returns a patch of the texture with one post per column
+static uint8_t *mergePatches(const maptexture_t *mtexture, lump_t *const *patches, uint32_t *length)
+{
+	int16_t width  = mtexture->width;
+	int16_t height = mtexture->height;
+
+	uint32_t columnofs = 8;
+	uint32_t posts     = columnofs + width * 4;
+	*length = posts + width * (height + 5);
+
+	uint8_t *patch = calloc(*length, 1);
+	writeInt16(&patch[0], width);
+	writeInt16(&patch[2], height);
+	writeInt16(&patch[4], 0);
+	writeInt16(&patch[6], 0);
+
+	uint8_t *cache = malloc(height);
+
+	for (int16_t x = 0; x < width; x++)
+	{
+		memset(cache, 0, height);
+
+		for (int j = 0; j < mtexture->patchcount; j++)
+		{
+			const mappatch_t *mpatch = &mtexture->patches[j];
+			int16_t x1 = mpatch->originx;
+			int16_t x2 = x1 + patchWidth(patches[j]);
+
+			if (x1 <= x && x < x2)
+			{
+				const uint8_t *realpatch = patches[j]->data;
+				const uint8_t *column = realpatch + (uint16_t)readInt32(&realpatch[columnofs + (x - x1) * 4]);
+				drawColumnInCache(column, cache, mpatch->originy, height);
+			}
+		}
+
+		uint32_t post = posts + x * (height + 5);
+		writeInt32(&patch[columnofs + x * 4], post);
+
+		patch[post + 0] = 0;      // topdelta
+		patch[post + 1] = height; // length
+		patch[post + 2] = cache[0];
+		memcpy(&patch[post + 3], cache, height);
+		patch[post + 3 + height] = cache[height - 1];
+		patch[post + 4 + height] = 0xff;
+	}
+
+	free(cache);
+	return patch;
+}
+
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3)
+	{
+		printf("Usage: %s input.wad output.wad\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	wadfile_t wad;
+	if (!WAD_Read(&wad, argv[1]))
+		return EXIT_FAILURE;
+
+	lump_t *pnamesLump  = getLump(&wad, "PNAMES");
+	lump_t *texture1    = getLump(&wad, "TEXTURE1");
+
+	int32_t numpnames   = readInt32(pnamesLump->data);
+	int32_t numtextures = readInt32(texture1->data);
+
+	// every merged texture adds a patch name
+	uint8_t *pnames = malloc(4 + (numpnames + numtextures) * 8);
+	memcpy(pnames, pnamesLump->data, 4 + numpnames * 8);
+
+	// the new TEXTURE1 is never larger than the old one
+	uint8_t *maptex = malloc(WAD_LumpLength(texture1));
+	uint32_t offset = 4 + numtextures * 4;
+	writeInt32(&maptex[0], numtextures);
+
+	int merged = 0;
+
+	for (int32_t i = 0; i < numtextures; i++)
+	{
+		const uint8_t *m = texture1->data + readInt32(&texture1->data[4 + i * 4]);
+
+		int16_t patchcount = readInt16(&m[12]);
+		maptexture_t *mtexture = malloc(MAPTEXTURE_HEADERSIZE + patchcount * sizeof(mappatch_t));
+		memcpy(mtexture->name, m, 8);
+		mtexture->width      = readInt16(&m[8]);
+		mtexture->height     = readInt16(&m[10]);
+		mtexture->patchcount = patchcount;
+
+		lump_t **patches = malloc(patchcount * sizeof(lump_t *));
+
+		for (int16_t j = 0; j < patchcount; j++)
+		{
+			const uint8_t *mp = &m[MAPTEXTURE_HEADERSIZE + j * sizeof(mappatch_t)];
+			mtexture->patches[j].originx = readInt16(&mp[0]);
+			mtexture->patches[j].originy = readInt16(&mp[2]);
+			mtexture->patches[j].patch   = readInt16(&mp[4]);
+
+			char name[9];
+			memcpy(name, &pnamesLump->data[4 + mtexture->patches[j].patch * 8], 8);
+			name[8] = '\0';
+			patches[j] = getLump(&wad, name);
+		}
+
+		writeInt32(&maptex[4 + i * 4], offset);
+
+		uint32_t length;
+		uint8_t *patch = NULL;
+		if (isOverlapped(mtexture, patches))
+		{
+			patch = mergePatches(mtexture, patches, &length);
+			if (length > 0xffff || mtexture->height > 0xff)
+			{
+				printf("%-8.8s too large to merge\n", mtexture->name);
+				free(patch);
+				patch = NULL;
+			}
+		}
+
+		if (patch)
+		{
+			char name[16];
+			sprintf(name, "TEXM%04d", merged);
+			if (WAD_FindLump(&wad, name) != -1)
+			{
+				printf("Lump %s already exists\n", name);
+				return EXIT_FAILURE;
+			}
+
+			lump_t *lump = WAD_InsertLump(&wad, wad.numlumps, name);
+			WAD_SetLumpData(lump, patch, length);
+			free(patch);
+
+			// WAD_InsertLump may have moved the lumps
+			pnamesLump = getLump(&wad, "PNAMES");
+			texture1   = getLump(&wad, "TEXTURE1");
+
+			memcpy(&pnames[4 + numpnames * 8], name, 8);
+
+			printf("%-8.8s %2d patches -> %s\n", mtexture->name, patchcount, name);
+
+			memcpy(&maptex[offset], m, MAPTEXTURE_HEADERSIZE);
+			writeInt16(&maptex[offset + 12], 1);
+			offset += MAPTEXTURE_HEADERSIZE;
+
+			writeInt16(&maptex[offset + 0], 0);
+			writeInt16(&maptex[offset + 2], 0);
+			writeInt16(&maptex[offset + 4], numpnames);
+			offset += sizeof(mappatch_t);
+
+			numpnames++;
+			merged++;
+		}
+		else
+		{
+			uint32_t size = MAPTEXTURE_HEADERSIZE + patchcount * sizeof(mappatch_t);
+			memcpy(&maptex[offset], m, size);
+			offset += size;
+		}
+
+		free(patches);
+		free(mtexture);
+	}
+
+	writeInt32(&pnames[0], numpnames);
+	WAD_SetLumpData(pnamesLump, pnames, 4 + numpnames * 8);
+	WAD_SetLumpData(texture1, maptex, offset);
+	free(pnames);
+	free(maptex);
+
+	printf("Merged %d textures\n", merged);
+
+	if (!WAD_Write(&wad, argv[2], NULL))
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+/*-----------------------------------------------------------------------------
+ *
+ *
+ *  Copyright (C) 2026 Frenkel Smeijers
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ *  02111-1307, USA.
+ *
+ * DESCRIPTION:
+ *      Host tool that compresses the lumps of a WAD file
+ *      in the format that W_ReadLumpByNum decompresses.
+ *      Usage: wadcomp DOOM1.WAD DOOMC.WAD
+ *
+ *-----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wadfile.h"
+
+
+#define MIN_MATCH	3
+#define MAX_MATCH	(0x7f + MIN_MATCH)
+#define MAX_LITERAL	0x80
+#define MAX_DISTANCE	0xffff
+
+#define HASH_SIZE	(1 << 14)
+#define MAX_CHAIN	256
+
+
+static int32_t head[HASH_SIZE];
+static int32_t chain[0x10000];
+
+
+static uint32_t hash3(const uint8_t *p)
+{
+	return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & (HASH_SIZE - 1);
+}
+
+
+static void flushLiterals(uint8_t *dest, size_t *d, const uint8_t *src, size_t start, size_t count)
+{
+	while (count)
+	{
+		size_t n = count > MAX_LITERAL ? MAX_LITERAL : count;
+		dest[(*d)++] = n - 1;
+		memcpy(&dest[*d], &src[start], n);
+		*d    += n;
+		start += n;
+		count -= n;
+	}
+}
+
+
+// Greedy LZ compression.
+// The first two bytes are always literals, so the engine can read
+// the first 16-bit value of a compressed patch without decompressing it.
+static size_t compress(uint8_t *dest, const uint8_t *src, size_t length)
+{
+	for (size_t i = 0; i < HASH_SIZE; i++)
+		head[i] = -1;
+
+	size_t d = 0;
+	size_t literalStart = 0;
+	size_t s = 0;
+
+	while (s < length)
+	{
+		size_t bestLength   = 0;
+		size_t bestDistance = 0;
+
+		if (s >= 2 && s + MIN_MATCH <= length)
+		{
+			int32_t candidate = head[hash3(&src[s])];
+			for (int chainLength = 0; candidate >= 0 && chainLength < MAX_CHAIN; chainLength++)
+			{
+				size_t distance = s - candidate;
+				if (distance > MAX_DISTANCE)
+					break;
+
+				size_t l = 0;
+				while (s + l < length && l < MAX_MATCH && src[candidate + l] == src[s + l])
+					l++;
+
+				if (l > bestLength)
+				{
+					bestLength   = l;
+					bestDistance = distance;
+					if (l == MAX_MATCH)
+						break;
+				}
+
+				candidate = chain[candidate];
+			}
+		}
+
+		if (bestLength >= MIN_MATCH)
+		{
+			flushLiterals(dest, &d, src, literalStart, s - literalStart);
+
+			dest[d++] = 0x80 | (bestLength - MIN_MATCH);
+			dest[d++] = bestDistance & 0xff;
+			dest[d++] = bestDistance >> 8;
+
+			for (size_t i = 0; i < bestLength; i++, s++)
+			{
+				if (s + MIN_MATCH <= length)
+				{
+					uint32_t h = hash3(&src[s]);
+					chain[s] = head[h];
+					head[h]  = s;
+				}
+			}
+
+			literalStart = s;
+		}
+		else
+		{
+			if (s + MIN_MATCH <= length)
+			{
+				uint32_t h = hash3(&src[s]);
+				chain[s] = head[h];
+				head[h]  = s;
+			}
+			s++;
+		}
+	}
+
+	flushLiterals(dest, &d, src, literalStart, s - literalStart);
+
+	return d;
+}
+
+
+// The engine reads the compressed data into the end of the destination
+// buffer and decompresses it in place.
+// Make sure the output never overwrites input that hasn't been read yet.
+static int isSafeInPlace(const uint8_t *compressed, size_t compressedLength, size_t length)
+{
+	size_t start = length - ((compressedLength + 1) & ~1);
+	size_t end   = start + compressedLength;
+	size_t out   = 0;
+	size_t c     = 0;
+
+	while (c < compressedLength)
+	{
+		uint8_t token = compressed[c++];
+		if (token < 0x80)
+		{
+			// every byte is read before it's written
+			for (size_t i = 0; i <= token; i++, c++, out++)
+			{
+				if (out > start + c && out < end)
+					return 0;
+			}
+		}
+		else
+		{
+			c += 2;
+			size_t first = out;
+			out += (token & 0x7f) + MIN_MATCH;
+			if (out > start + c && first < end && start + c < end)
+				return 0;
+		}
+	}
+
+	return out == length;
+}
+
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3)
+	{
+		printf("Usage: %s input.wad output.wad\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	wadfile_t wad;
+	if (!WAD_Read(&wad, argv[1]))
+		return EXIT_FAILURE;
+
+	uint8_t *compressed = malloc(0x10000 + 0x10000 / MAX_LITERAL + 1);
+
+	uint32_t totalSize = 0;
+	uint32_t totalCompressedSize = 0;
+
+	printf("Lump       Size  Compressed  Ratio\n");
+
+	for (int i = 0; i < wad.numlumps; i++)
+	{
+		lump_t *lump = &wad.lumps[i];
+
+		totalSize += lump->size;
+
+		if (lump->size < 16 || lump->compressedsize)
+		{
+			totalCompressedSize += lump->size;
+			continue;
+		}
+
+		size_t compressedLength = compress(compressed, lump->data, lump->size);
+		if (compressedLength >= lump->size || !isSafeInPlace(compressed, compressedLength, lump->size))
+		{
+			printf("%-8.8s %6u %11s\n", lump->name, lump->size, "-");
+			totalCompressedSize += lump->size;
+			continue;
+		}
+
+		printf("%-8.8s %6u %11u %5.1f%%\n", lump->name, lump->size, (unsigned)compressedLength, 100.0 * compressedLength / lump->size);
+		totalCompressedSize += compressedLength;
+
+		uint16_t size = lump->size;
+		WAD_SetLumpData(lump, compressed, compressedLength);
+		lump->size           = size;
+		lump->compressedsize = compressedLength;
+	}
+
+	printf("Total    %6u %11u %5.1f%%\n", totalSize, totalCompressedSize, 100.0 * totalCompressedSize / totalSize);
+
+	if (!WAD_Write(&wad, argv[2], NULL))
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,202 @@
+/*-----------------------------------------------------------------------------
+ *
+ *
+ *  Copyright (C) 2026 Frenkel Smeijers
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ *  02111-1307, USA.
+ *
+ * DESCRIPTION:
+ *      Reading and writing WAD files for the host tools
+ *
+ *-----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wadfile.h"
+
+
+// WAD files are little endian, so are the hosts these tools run on.
+
+typedef struct
+{
+	char identification[4];
+	int32_t numlumps;
+	int32_t infotableofs;
+} wadinfo_t;
+
+typedef struct
+{
+	int32_t  filepos;
+	uint16_t size;
+	uint16_t compressedsize;
+	char name[8];
+} filelump_t;
+
+
+int WAD_Read(wadfile_t *wad, const char *filename)
+{
+	FILE *fp = fopen(filename, "rb");
+	if (!fp)
+	{
+		printf("Can't open %s\n", filename);
+		return 0;
+	}
+
+	wadinfo_t header;
+	if (fread(&header, sizeof(header), 1, fp) != 1
+	 || (memcmp(header.identification, "IWAD", 4) && memcmp(header.identification, "PWAD", 4)))
+	{
+		printf("%s isn't a WAD file\n", filename);
+		fclose(fp);
+		return 0;
+	}
+
+	filelump_t *fileinfo = malloc(header.numlumps * sizeof(filelump_t));
+	fseek(fp, header.infotableofs, SEEK_SET);
+	fread(fileinfo, sizeof(filelump_t), header.numlumps, fp);
+
+	memcpy(wad->identification, header.identification, 4);
+	wad->numlumps = header.numlumps;
+	wad->lumps    = calloc(header.numlumps, sizeof(lump_t));
+
+	for (int i = 0; i < header.numlumps; i++)
+	{
+		lump_t *lump = &wad->lumps[i];
+		memcpy(lump->name, fileinfo[i].name, 8);
+		lump->size           = fileinfo[i].size;
+		lump->compressedsize = fileinfo[i].compressedsize;
+
+		uint32_t length = WAD_LumpLength(lump);
+		lump->data = malloc(length ? length : 1);
+		fseek(fp, fileinfo[i].filepos, SEEK_SET);
+		if (fread(lump->data, 1, length, fp) != length)
+		{
+			printf("Error reading lump %.8s\n", lump->name);
+			free(fileinfo);
+			fclose(fp);
+			return 0;
+		}
+	}
+
+	free(fileinfo);
+	fclose(fp);
+	return 1;
+}
+
+
+// order is the order in which the lump data is written,
+// NULL for the order of the directory.
+// The directory itself always keeps its order.
+int WAD_Write(const wadfile_t *wad, const char *filename, const int *order)
+{
+	FILE *fp = fopen(filename, "wb");
+	if (!fp)
+	{
+		printf("Can't create %s\n", filename);
+		return 0;
+	}
+
+	filelump_t *fileinfo = malloc(wad->numlumps * sizeof(filelump_t));
+
+	wadinfo_t header;
+	fwrite(&header, sizeof(header), 1, fp);
+
+	for (int n = 0; n < wad->numlumps; n++)
+	{
+		int i = order ? order[n] : n;
+		const lump_t *lump = &wad->lumps[i];
+		uint32_t length = WAD_LumpLength(lump);
+
+		fileinfo[i].filepos        = ftell(fp);
+		fileinfo[i].size           = lump->size;
+		fileinfo[i].compressedsize = lump->compressedsize;
+		memcpy(fileinfo[i].name, lump->name, 8);
+
+		fwrite(lump->data, 1, length, fp);
+
+		// keep the lumps word aligned
+		if (length & 1)
+			fputc(0, fp);
+	}
+
+	memcpy(header.identification, wad->identification, 4);
+	header.numlumps     = wad->numlumps;
+	header.infotableofs = ftell(fp);
+	fwrite(fileinfo, sizeof(filelump_t), wad->numlumps, fp);
+
+	fseek(fp, 0, SEEK_SET);
+	fwrite(&header, sizeof(header), 1, fp);
+
+	free(fileinfo);
+
+	int ok = !ferror(fp);
+	fclose(fp);
+	if (!ok)
+		printf("Error writing %s\n", filename);
+
+	return ok;
+}
+
+
+int WAD_FindLumpAfter(const wadfile_t *wad, int start, const char *name)
+{
+	for (int i = start; i < wad->numlumps; i++)
+	{
+		if (!strncasecmp(wad->lumps[i].name, name, 8))
+			return i;
+	}
+
+	return -1;
+}
+
+
+int WAD_FindLump(const wadfile_t *wad, const char *name)
+{
+	return WAD_FindLumpAfter(wad, 0, name);
+}
+
+
+uint32_t WAD_LumpLength(const lump_t *lump)
+{
+	return lump->compressedsize ? lump->compressedsize : lump->size;
+}
+
+
+void WAD_SetLumpData(lump_t *lump, const void *data, uint32_t length)
+{
+	free(lump->data);
+	lump->data = malloc(length ? length : 1);
+	memcpy(lump->data, data, length);
+	lump->size           = length;
+	lump->compressedsize = 0;
+}
+
+
+lump_t *WAD_InsertLump(wadfile_t *wad, int position, const char *name)
+{
+	wad->lumps = realloc(wad->lumps, (wad->numlumps + 1) * sizeof(lump_t));
+	memmove(&wad->lumps[position + 1], &wad->lumps[position], (wad->numlumps - position) * sizeof(lump_t));
+	wad->numlumps++;
+
+	lump_t *lump = &wad->lumps[position];
+	memset(lump, 0, sizeof(lump_t));
+	for (int i = 0; i < 8 && name[i]; i++)
+		lump->name[i] = name[i];
+	lump->data = malloc(1);
+	return lump;
+}
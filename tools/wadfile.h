@@ -0,0 +1,58 @@
+/*-----------------------------------------------------------------------------
+ *
+ *
+ *  Copyright (C) 2026 Frenkel Smeijers
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ *  02111-1307, USA.
+ *
+ * DESCRIPTION:
+ *      Reading and writing WAD files for the host tools
+ *
+ *-----------------------------------------------------------------------------*/
+
+#ifndef __WADFILE__
+#define __WADFILE__
+
+#include <stdint.h>
+
+
+typedef struct
+{
+	char name[8];
+	uint16_t size;           // uncompressed size
+	uint16_t compressedsize; // zero if the lump isn't compressed
+	uint8_t *data;           // as stored in the WAD file
+} lump_t;
+
+typedef struct
+{
+	char identification[4];
+	int numlumps;
+	lump_t *lumps;
+} wadfile_t;
+
+
+int WAD_Read(wadfile_t *wad, const char *filename);
+int WAD_Write(const wadfile_t *wad, const char *filename, const int *order);
+
+int WAD_FindLump(const wadfile_t *wad, const char *name);
+int WAD_FindLumpAfter(const wadfile_t *wad, int start, const char *name);
+uint32_t WAD_LumpLength(const lump_t *lump);
+
+void WAD_SetLumpData(lump_t *lump, const void *data, uint32_t length);
+lump_t *WAD_InsertLump(wadfile_t *wad, int position, const char *name);
+
+#endif
@@ -0,0 +1,99 @@
+/*-----------------------------------------------------------------------------
+ *
+ *
+ *  Copyright (C) 2026 Frenkel Smeijers
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ *  02111-1307, USA.
+ *
+ * DESCRIPTION:
+ *      Host tool that lays out the lumps of a WAD file
+ *      in the order in which they were first accessed,
+ *      according to a trace made with -lumptrace.
+ *      The directory keeps its order.
+ *      Usage: wadorder DOOM1.WAD LUMPTRAC.CSV DOOM1O.WAD
+ *
+ *-----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wadfile.h"
+
+
+int main(int argc, char *argv[])
+{
+	if (argc != 4)
+	{
+		printf("Usage: %s input.wad lumptrac.csv output.wad\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	wadfile_t wad;
+	if (!WAD_Read(&wad, argv[1]))
+		return EXIT_FAILURE;
+
+	FILE *fp = fopen(argv[2], "r");
+	if (!fp)
+	{
+		printf("Can't open %s\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+
+	int *order    = malloc(wad.numlumps * sizeof(int));
+	char *ordered = calloc(wad.numlumps, 1);
+	int numordered = 0;
+
+	char line[80];
+	fgets(line, sizeof(line), fp); // header
+
+	while (fgets(line, sizeof(line), fp))
+	{
+		long gametic;
+		int num;
+		char name[9];
+		if (sscanf(line, "%ld,%d,%8[^,]", &gametic, &num, name) != 3)
+			continue;
+
+		if (num < 0 || num >= wad.numlumps || strncmp(wad.lumps[num].name, name, 8))
+		{
+			printf("%s doesn't belong to %s: lump %d isn't %s\n", argv[2], argv[1], num, name);
+			return EXIT_FAILURE;
+		}
+
+		if (!ordered[num])
+		{
+			ordered[num] = 1;
+			order[numordered++] = num;
+		}
+	}
+
+	fclose(fp);
+
+	printf("%d of %d lumps have been accessed\n", numordered, wad.numlumps);
+
+	// the lumps that haven't been accessed go at the end
+	for (int i = 0; i < wad.numlumps; i++)
+	{
+		if (!ordered[i])
+			order[numordered++] = i;
+	}
+
+	if (!WAD_Write(&wad, argv[3], order))
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
@@ -42,6 +42,7 @@
 #include <unistd.h>
 #endif
 
+#include <dos.h>
 #include <stdint.h>
 
 #include "compiler.h"
@@ -64,7 +65,7 @@ typedef struct
 {
   int32_t  filepos;
   uint16_t size;
-  int16_t  filler;        // always zero
+  uint16_t compressedsize; // zero if the lump isn't compressed
   char name[8];
 } filelump_t;
 
@@ -73,7 +74,15 @@ typedef struct
 // GLOBALS
 //
 
+#if !defined WAD_FILE
+#define WAD_FILE "DOOM1.WAD"
+#endif
+
+#if defined _M_I86
+static uint16_t handleWAD;
+#else
 static FILE* fileWAD;
+#endif
 
 static int16_t numlumps;
 
@@ -81,81 +90,266 @@ static filelump_t __far* fileinfo;
 
 static void __far*__far* lumpcache;
 
+//
+// Lump pinning
+// A pinned lump stays in static memory.
+// When its last pin is removed, it stays there until the end of the frame,
+// so pinning it again in the same frame doesn't change its tag.
+//
+
+#define PIN_DEFERRED	0x80	// unpinned, waiting for the end of the frame
+#define PIN_COUNTMASK	0x7f
+
+#define MAXDEFERREDLUMPS 64
+
+static uint8_t __far* pincounts;
+static int16_t deferredlumps[MAXDEFERREDLUMPS];
+static int16_t numdeferredlumps;
+
+
+//
+// Lump name hash table
+// Open addressing with linear probing,
+// every entry is a lump number, -1 if empty.
+//
+
+static int16_t __far* lumphash;
+static uint16_t lumphashmask;
+
+
+//
+// Second level lump cache
+//
+// When the WAD doesn't fit in XMS,
+// lumps read from disk are also copied to the XMS or the EMS memory that is available.
+// The cache is a ring buffer of 32 byte units.
+// A lump that is used while it's in the older half of the ring buffer
+// is copied to the front again, so the least recently used lumps are overwritten first.
+//
+
+#define CACHE_UNIT 32
+
+typedef void (*W_ReadData_f)(void __far* dest, uint32_t src, uint16_t length);
+typedef void (*W_WriteData_f)(uint32_t dest, const void __far* src, uint16_t length);
+
+static W_ReadData_f  cachereadfunc;
+static W_WriteData_f cachewritefunc;
+
+static uint32_t cachesize;
+static uint32_t cachepos;
+
+// position in the cache in units + 1, 0 if not cached
+static uint16_t __far* cacheunits;
+
+// the cached lumps from the least to the most recently stored one,
+// in the order of their positions in the ring buffer
+static int16_t __far* cachenext;
+static int16_t __far* cacheprev;
+static int16_t cachehead = -1;
+static int16_t cachetail = -1;
+
+
 //
 // LUMP BASED ROUTINES.
 //
 
-#define BUFFERSIZE 512
+//
+// The WAD is opened and read with DOS calls only,
+// straight into the far destination.
+//
+
+#if defined _M_I86
+#define	DOS_INT		0x21
 
-static void _ffread(void __far* ptr, uint16_t size, FILE* fp)
+#define	DOS_OPEN	0x3d
+#define	DOS_READ	0x3f
+#define	DOS_SEEK	0x42
+
+static void W_Open(void)
 {
-	uint8_t __far* dest = ptr;
-	uint8_t buffer[BUFFERSIZE];
+	union REGS regs;
+	struct SREGS sregs;
+	const char __far* filename = WAD_FILE;
 
-	while (size >= BUFFERSIZE)
-	{
-		fread(buffer, BUFFERSIZE, 1, fp);
-		_fmemcpy(dest, buffer, BUFFERSIZE);
-		dest += BUFFERSIZE;
-		size -= BUFFERSIZE;
-	}
+	regs.h.ah = DOS_OPEN;
+	regs.h.al = 0; // read only
+	regs.w.dx = D_FP_OFF(filename);
+	sregs.ds  = D_FP_SEG(filename);
+	int86x(DOS_INT, &regs, &regs, &sregs);
 
-	if (size > 0)
-	{
-		fread(buffer, size, 1, fp);
-		_fmemcpy(dest, buffer, size);
-	}
+	if (regs.w.cflag)
+		I_Error("Can't open " WAD_FILE ".");
+
+	handleWAD = regs.w.ax;
+}
+
+
+static void W_ReadData(void __far* dest, uint16_t length)
+{
+	union REGS regs;
+	struct SREGS sregs;
+
+	regs.h.ah = DOS_READ;
+	regs.w.bx = handleWAD;
+	regs.w.cx = length;
+	regs.w.dx = D_FP_OFF(dest);
+	sregs.ds  = D_FP_SEG(dest);
+	int86x(DOS_INT, &regs, &regs, &sregs);
+
+	if (regs.w.cflag)
+		I_Error("W_ReadData: Error %u reading " WAD_FILE, regs.w.ax);
+	else if (regs.w.ax != length)
+		I_Error("W_ReadData: Read %u of %u bytes", regs.w.ax, length);
+}
+
+
+// Returns the new position
+static uint32_t W_Seek(uint32_t pos, uint8_t origin)
+{
+	union REGS regs;
+
+	regs.h.ah = DOS_SEEK;
+	regs.h.al = origin;
+	regs.w.bx = handleWAD;
+	regs.w.cx = pos >> 16;
+	regs.w.dx = pos;
+	int86(DOS_INT, &regs, &regs);
+
+	if (regs.w.cflag)
+		I_Error("W_Seek: Error %u seeking to %li", regs.w.ax, pos);
+
+	return (((uint32_t)regs.w.dx) << 16) | regs.w.ax;
+}
+#else
+static void W_ReadData(void __far* dest, uint16_t length)
+{
+	if (fread(dest, length, 1, fileWAD) != 1)
+		I_Error("W_ReadData: Error reading " WAD_FILE);
 }
 
 
+static void W_Seek(uint32_t pos, uint8_t origin)
+{
+	if (fseek(fileWAD, pos, origin))
+		I_Error("W_Seek: Error seeking to %li", pos);
+}
+#endif
+
+
+#if defined _M_I86
+#define BUFFERSIZE 512
+#define MAXBUFFERSIZE 32768
+
 static boolean W_LoadWADIntoXMS(void)
 {
-	fseek(fileWAD, 0, SEEK_END);
-	int32_t size = ftell(fileWAD);
-	boolean xms = Z_InitXms(size);
-	if (!xms)
+	int32_t size = W_Seek(0, SEEK_END);
+	uint32_t xmssize = Z_InitXms(size);
+	if (xmssize == 0)
+	{
+		printf("No XMS available\n");
+		return false;
+	}
+	else if (xmssize < size)
 	{
-		printf("Not enough XMS available\n");
+		printf("Not enough XMS available, caching lumps in %ld bytes of XMS\n", xmssize);
+		cachesize      = xmssize;
+		cachereadfunc  = Z_MoveExtendedMemoryToConventionalMemory;
+		cachewritefunc = Z_MoveConventionalMemoryToExtendedMemory;
 		return false;
 	}
 
 	printf("Loading WAD into XMS\n");
 	printf("Get Psyched!\n");
 
-	uint8_t buffer[BUFFERSIZE];
+	// borrow the largest buffer the zone can spare
+	uint16_t buffersize = MAXBUFFERSIZE;
+	uint8_t __far* buffer = Z_TryMallocStatic(buffersize);
+	while (!buffer && buffersize > BUFFERSIZE)
+	{
+		buffersize /= 2;
+		buffer = Z_TryMallocStatic(buffersize);
+	}
 
-	fseek(fileWAD, 0, SEEK_SET);
+	if (!buffer)
+		I_Error("W_LoadWADIntoXMS: Not enough memory for a buffer");
+
+	W_Seek(0, SEEK_SET);
 	uint32_t dest = 0;
 
-	while (size >= BUFFERSIZE)
+	while (size >= buffersize)
 	{
-		fread(buffer, BUFFERSIZE, 1, fileWAD);
-		Z_MoveConventionalMemoryToExtendedMemory(dest, buffer, BUFFERSIZE);
-		dest += BUFFERSIZE;
-		size -= BUFFERSIZE;
+		W_ReadData(buffer, buffersize);
+		Z_MoveConventionalMemoryToExtendedMemory(dest, buffer, buffersize);
+		dest += buffersize;
+		size -= buffersize;
 	}
 
 	if (size > 0)
 	{
-		fread(buffer, size, 1, fileWAD);
+		W_ReadData(buffer, size);
 		Z_MoveConventionalMemoryToExtendedMemory(dest, buffer, size);
 	}
 
+	Z_Free(buffer);
+
 	return true;
 }
+#endif
 
 
 static void W_ReadDataFromFile(void __far* dest, uint32_t src, uint16_t length)
 {
-	fseek(fileWAD, src, SEEK_SET);
-	_ffread(dest, length, fileWAD);
+	W_Seek(src, SEEK_SET);
+	W_ReadData(dest, length);
 }
 
 
-typedef void (*W_ReadData_f)(void __far* dest, uint32_t src, uint16_t length);
 static W_ReadData_f readfunc;
 
 
+#if !defined _M_I86
+//
+// The 32-bit builds load the whole WAD file into memory.
+// Lumps that aren't compressed point straight into it,
+// the zone ignores these pointers.
+//
+
+static const uint8_t* wadmemory;
+
+#define W_IsLumpInMemory(num) (wadmemory && !fileinfo[num].compressedsize)
+
+static boolean W_LoadWADIntoMemory(void)
+{
+	fseek(fileWAD, 0, SEEK_END);
+	int32_t size = ftell(fileWAD);
+
+	uint8_t* ptr = malloc(size);
+	if (ptr == NULL)
+	{
+		printf("Not enough memory to load the WAD\n");
+		return false;
+	}
+
+	printf("Loading WAD into memory\n");
+
+	fseek(fileWAD, 0, SEEK_SET);
+	if (fread(ptr, size, 1, fileWAD) != 1)
+		I_Error("W_LoadWADIntoMemory: Error reading the WAD");
+
+	wadmemory = ptr;
+	return true;
+}
+
+
+static void W_ReadDataFromMemory(void __far* dest, uint32_t src, uint16_t length)
+{
+	memcpy(dest, wadmemory + src, length);
+}
+#else
+#define W_IsLumpInMemory(num) false
+#endif
+
+
 typedef struct
 {
   char identification[4]; // Should be "IWAD" or "PWAD".
@@ -164,38 +358,245 @@ typedef struct
   int32_t  infotableofs;
 } wadinfo_t;
 
-#if !defined WAD_FILE
-#define WAD_FILE "DOOM1.WAD"
+static uint16_t W_HashName(const char __far* name)
+{
+	uint16_t hash = 0;
+
+	for (int16_t i = 0; i < 8; i++)
+		hash = ((hash << 5) | (hash >> 11)) ^ (uint8_t)name[i];
+
+	return hash;
+}
+
+
+static void W_InitLumpHash(void)
+{
+	uint16_t size = 1;
+	while (size < numlumps + numlumps / 2)
+		size <<= 1;
+
+	lumphashmask = size - 1;
+	lumphash = Z_MallocStatic(size * sizeof(*lumphash));
+	_fmemset(lumphash, 0xff, size * sizeof(*lumphash));
+
+	// when lumps have the same name, the first one that is added is found
+#if BACKWARDS
+	for (int16_t i = numlumps - 1; i >= 0; i--)
+#else
+	for (int16_t i = 0; i < numlumps; i++)
 #endif
+	{
+		uint16_t h = W_HashName(fileinfo[i].name) & lumphashmask;
+
+		while (lumphash[h] != -1 && !Z_EqualNames(fileinfo[i].name, fileinfo[lumphash[h]].name))
+			h = (h + 1) & lumphashmask;
+
+		if (lumphash[h] == -1)
+			lumphash[h] = i;
+	}
+}
+
+
+//
+// Lump access trace
+// Logs every lump access to a CSV file when -lumptrace is given,
+// tools/wadorder.c reorders the WAD file with it.
+// hit: 0 = read from the WAD file, 1 = in lumpcache, 2 = in the lump cache
+//
+
+#define LUMPTRACE_FILE "LUMPTRAC.CSV"
+
+static FILE* tracefile;
+
+static void W_InitTrace(void)
+{
+	if (!M_CheckParm("-lumptrace"))
+		return;
+
+	tracefile = fopen(LUMPTRACE_FILE, "w");
+	if (tracefile == NULL)
+		I_Error("W_InitTrace: Can't open " LUMPTRACE_FILE);
+
+	fprintf(tracefile, "gametic,lump,name,size,hit\n");
+}
+
+
+static void W_TraceLump(int16_t num, uint8_t hit)
+{
+	if (!tracefile)
+		return;
+
+	char name[8];
+	_fmemcpy(name, fileinfo[num].name, sizeof(name));
+	fprintf(tracefile, "%ld,%d,%.8s,%u,%u\n", _g_gametic, num, name, fileinfo[num].size, hit);
+}
+
 
 void W_Init(void)
 {
 	printf("\tadding " WAD_FILE "\n");
 	printf("\tshareware version.\n");
 
+#if defined _M_I86
+	W_Open();
+#else
 	fileWAD = fopen(WAD_FILE, "rb");
 	if (fileWAD == NULL)
 		I_Error("Can't open " WAD_FILE ".");
+#endif
 
+#if defined _M_I86
 	boolean xms = W_LoadWADIntoXMS();
 	readfunc = xms ? Z_MoveExtendedMemoryToConventionalMemory : W_ReadDataFromFile;
+#else
+	boolean xms = W_LoadWADIntoMemory();
+	readfunc = xms ? W_ReadDataFromMemory : W_ReadDataFromFile;
+#endif
+
+	// before anything is allocated in the EMS block
+	if (!xms && !cachesize)
+	{
+		cachesize = Z_InitExpandedMemoryCache();
+		if (cachesize)
+		{
+			printf("\tcaching lumps in %ld bytes of EMS\n", cachesize);
+			cachereadfunc  = Z_MoveExpandedMemoryToConventionalMemory;
+			cachewritefunc = Z_MoveConventionalMemoryToExpandedMemory;
+		}
+	}
 
 	wadinfo_t header;
 	readfunc(&header, 0, sizeof(header));
 
-	fileinfo = Z_MallocStatic(header.numlumps * sizeof(filelump_t));
-	readfunc(fileinfo, header.infotableofs, sizeof(filelump_t) * header.numlumps);
+#if !defined _M_I86
+	if (wadmemory)
+		fileinfo = (filelump_t*)(wadmemory + header.infotableofs);
+	else
+#endif
+	{
+		fileinfo = Z_MallocStatic(header.numlumps * sizeof(filelump_t));
+		readfunc(fileinfo, header.infotableofs, sizeof(filelump_t) * header.numlumps);
+	}
 
 	lumpcache = Z_MallocStatic(header.numlumps * sizeof(*lumpcache));
 	_fmemset(lumpcache, 0, header.numlumps * sizeof(*lumpcache));
 
+#if !defined _M_I86
+	for (int16_t i = 0; i < header.numlumps; i++)
+	{
+		if (W_IsLumpInMemory(i))
+			lumpcache[i] = (void*)(wadmemory + fileinfo[i].filepos);
+	}
+#endif
+
+	pincounts = Z_MallocStatic(header.numlumps * sizeof(*pincounts));
+	_fmemset(pincounts, 0, header.numlumps * sizeof(*pincounts));
+
 	numlumps = header.numlumps;
+
+	W_InitLumpHash();
+
+	if (cachesize)
+	{
+		if (cachesize > 0xffffL * CACHE_UNIT)
+			cachesize = 0xffffL * CACHE_UNIT;
+
+		cacheunits = Z_MallocStatic(numlumps * sizeof(*cacheunits));
+		_fmemset(cacheunits, 0, numlumps * sizeof(*cacheunits));
+
+		cachenext = Z_MallocStatic(numlumps * sizeof(*cachenext));
+		cacheprev = Z_MallocStatic(numlumps * sizeof(*cacheprev));
+	}
+
+	W_InitTrace();
 }
 
 
 void W_Shutdown(void)
 {
 	readfunc = W_ReadDataFromFile;
+	cachesize = 0;
+
+	if (tracefile)
+	{
+		fclose(tracefile);
+		tracefile = NULL;
+	}
+}
+
+
+static void W_UncacheLump(int16_t num)
+{
+	int16_t prev = cacheprev[num];
+	int16_t next = cachenext[num];
+
+	if (prev == -1)
+		cachehead = next;
+	else
+		cachenext[prev] = next;
+
+	if (next == -1)
+		cachetail = prev;
+	else
+		cacheprev[next] = prev;
+
+	cacheunits[num] = 0;
+}
+
+
+static void W_StoreLumpInCache(int16_t num, const void __far* ptr)
+{
+	uint32_t size = (fileinfo[num].size + (CACHE_UNIT - 1)) & ~(CACHE_UNIT - 1);
+	if (size == 0 || size > cachesize / 4)
+		return;
+
+	// a lump that is moved to the front leaves its old position
+	if (cacheunits[num])
+		W_UncacheLump(num);
+
+	uint32_t start = cachepos;
+	if (cachepos + size > cachesize)
+		cachepos = 0;
+
+	uint32_t end = cachepos + size;
+
+	// the part of the ring buffer from start on that is overwritten or skipped
+	uint32_t overwritten = cachepos < start ? cachesize - start + end : size;
+
+	// throw out the lumps in it, those are the least recently stored ones
+	while (cachehead != -1)
+	{
+		uint32_t pos = (cacheunits[cachehead] - 1) * (uint32_t)CACHE_UNIT;
+		uint32_t distance = pos >= start ? pos - start : cachesize - start + pos;
+		if (distance >= overwritten)
+			break;
+
+		W_UncacheLump(cachehead);
+	}
+
+	cachewritefunc(cachepos, ptr, fileinfo[num].size);
+	cacheunits[num] = cachepos / CACHE_UNIT + 1;
+	cachepos = end;
+
+	cacheprev[num] = cachetail;
+	cachenext[num] = -1;
+	if (cachetail == -1)
+		cachehead = num;
+	else
+		cachenext[cachetail] = num;
+	cachetail = num;
+}
+
+
+static void W_ReadLumpFromCache(int16_t num, void __far* ptr)
+{
+	uint32_t pos = (cacheunits[num] - 1) * (uint32_t)CACHE_UNIT;
+	cachereadfunc(ptr, pos, fileinfo[num].size);
+
+	// move it to the front when it's about to be overwritten
+	uint32_t age = pos < cachepos ? cachepos - pos : cachesize - pos + cachepos;
+	if (age > cachesize / 2)
+		W_StoreLumpInCache(num, ptr);
 }
 
 
@@ -216,35 +617,105 @@ uint16_t PUREFUNC W_LumpLength(int16_t num)
 }
 
 
-// W_GetNumForName
-// bombs out if not found.
+// W_CheckNumForName
+// Returns -1 if name not found.
 //
-int16_t PUREFUNC W_GetNumForName(const char *name)
+int16_t PUREFUNC W_CheckNumForName(const char *name)
 {
 	char name8[8];
 	strncpy(name8, name, sizeof(name8));
 
-#if BACKWARDS
-	for (int16_t i = numlumps - 1; i >= 0; i--)
-#else
-	for (int16_t i = 0; i < numlumps; i++)
-#endif
+	for (uint16_t h = W_HashName(name8) & lumphashmask; lumphash[h] != -1; h = (h + 1) & lumphashmask)
 	{
-		if (Z_EqualNames(fileinfo[i].name, name8))
+		if (Z_EqualNames(fileinfo[lumphash[h]].name, name8))
 		{
-			return i;
+			return lumphash[h];
 		}
 	}
 
-	I_Error("W_GetNumForName: %.8s not found", name);
 	return -1;
 }
 
 
+// W_GetNumForName
+// bombs out if not found.
+//
+int16_t PUREFUNC W_GetNumForName(const char *name)
+{
+	int16_t num = W_CheckNumForName(name);
+
+	if (num == -1)
+		I_Error("W_GetNumForName: %.8s not found", name);
+
+	return num;
+}
+
+
+//
+// Compressed lumps
+//
+// A compressed lump is a sequence of tokens:
+//  0x00 - 0x7f: a run of token + 1 literal bytes follows
+//  0x80 - 0xff: copy (token & 0x7f) + 3 bytes, the next two bytes are
+//               the little endian distance back into the output
+// A compressed lump starts with a run of at least two literal bytes.
+//
+// The compressed data is read into the end of the destination buffer
+// and decompressed in place. The compressor makes sure the output
+// never overtakes the input.
+//
+
+static void W_Decompress(uint8_t __far* dest, const uint8_t __far* src, uint16_t length)
+{
+	while (length)
+	{
+		uint8_t token = *src++;
+		uint8_t count;
+
+		if (token < 0x80)
+		{
+			count = token + 1;
+			length -= count;
+
+			do
+			{
+				*dest++ = *src++;
+			} while (--count);
+		}
+		else
+		{
+			uint16_t distance = src[0] | (src[1] << 8);
+			src += 2;
+
+			const uint8_t __far* match = dest - distance;
+
+			count = (token & 0x7f) + 3;
+			length -= count;
+
+			do
+			{
+				*dest++ = *match++;
+			} while (--count);
+		}
+	}
+}
+
+
 void W_ReadLumpByNum(int16_t num, void __far* ptr)
 {
 	const filelump_t __far* lump = &fileinfo[num];
-	readfunc(ptr, lump->filepos, lump->size);
+
+	W_TraceLump(num, 0);
+
+	if (lump->compressedsize)
+	{
+		// XMS moves an even number of bytes
+		uint8_t __far* src = (uint8_t __far*)ptr + lump->size - ((lump->compressedsize + 1) & ~1);
+		readfunc(src, lump->filepos, lump->compressedsize);
+		W_Decompress(ptr, src, lump->size);
+	}
+	else
+		readfunc(ptr, lump->filepos, lump->size);
 }
 
 
@@ -252,9 +723,22 @@ const void __far* PUREFUNC W_GetLumpByNumAutoFree(int16_t num)
 {
 	const filelump_t __far* lump = &fileinfo[num];
 
+	if (W_IsLumpInMemory(num))
+		return lumpcache[num];
+
+	if (lumpcache[num])
+	{
+		// it has been prefetched, take it over
+		const void __far* ptr = lumpcache[num];
+		W_TraceLump(num, 1);
+		Z_ChangeTagToLevel(ptr);
+		lumpcache[num] = NULL;
+		return ptr;
+	}
+
 	void __far* ptr = Z_MallocLevel(lump->size, NULL);
 
-	readfunc(ptr, lump->filepos, lump->size);
+	W_ReadLumpByNum(num, ptr);
 	return ptr;
 }
 
@@ -265,7 +749,19 @@ static void __far* PUREFUNC W_GetLumpByNumWithUser(int16_t num, void __far*__far
 
 	void __far* ptr = Z_MallocStaticWithUser(lump->size, user);
 
-	readfunc(ptr, lump->filepos, lump->size);
+	if (cachesize && cacheunits[num])
+	{
+		W_TraceLump(num, 2);
+		W_ReadLumpFromCache(num, ptr);
+	}
+	else
+	{
+		W_ReadLumpByNum(num, ptr);
+
+		if (cachesize)
+			W_StoreLumpInCache(num, ptr);
+	}
+
 	return ptr;
 }
 
@@ -274,6 +770,16 @@ int16_t W_GetFirstInt16(int16_t num)
 {
 	const filelump_t __far* lump = &fileinfo[num];
 
+	W_TraceLump(num, 0);
+
+	if (lump->compressedsize)
+	{
+		// skip the token of the first run of literal bytes
+		uint8_t buffer[4];
+		readfunc(buffer, lump->filepos, 3);
+		return buffer[1] | (buffer[2] << 8);
+	}
+
 	int16_t firstInt16;
 
 	readfunc(&firstInt16, lump->filepos, sizeof(int16_t));
@@ -284,7 +790,10 @@ int16_t W_GetFirstInt16(int16_t num)
 const void __far* PUREFUNC W_GetLumpByNum(int16_t num)
 {
 	if (lumpcache[num])
+	{
+		W_TraceLump(num, 1);
 		Z_ChangeTagToStatic(lumpcache[num]);
+	}
 	else
 		lumpcache[num] = W_GetLumpByNumWithUser(num, &lumpcache[num]);
 
@@ -292,6 +801,21 @@ const void __far* PUREFUNC W_GetLumpByNum(int16_t num)
 }
 
 
+//
+// W_PrefetchLumpByNum
+// Loads a lump into purgable memory, if it fits in free memory.
+// Returns true if the lump had to be read.
+//
+boolean W_PrefetchLumpByNum(int16_t num)
+{
+	if (lumpcache[num] || fileinfo[num].size == 0 || !Z_IsFreeBlockAvailable(fileinfo[num].size))
+		return false;
+
+	Z_ChangeTagToCache(W_GetLumpByNum(num));
+	return true;
+}
+
+
 boolean PUREFUNC W_IsLumpCached(int16_t num)
 {
 	return lumpcache[num] != NULL;
@@ -302,6 +826,7 @@ const void __far* PUREFUNC W_TryGetLumpByNum(int16_t num)
 {
 	if (lumpcache[num])
 	{
+		W_TraceLump(num, 1);
 		Z_ChangeTagToStatic(lumpcache[num]);
 		return lumpcache[num];
 	}
@@ -310,3 +835,88 @@ const void __far* PUREFUNC W_TryGetLumpByNum(int16_t num)
 	else
 		return NULL;
 }
+
+
+//
+// W_ReleaseDeferredLumps
+// Makes the lumps without pins purgable again.
+//
+static void W_ReleaseDeferredLumps(void)
+{
+	for (int16_t i = 0; i < numdeferredlumps; i++)
+	{
+		int16_t num = deferredlumps[i];
+
+		pincounts[num] &= PIN_COUNTMASK;
+
+		// the lump can be pinned again, or it can have been freed
+		if (pincounts[num] == 0 && lumpcache[num])
+			Z_ChangeTagToCache(lumpcache[num]);
+	}
+
+	numdeferredlumps = 0;
+}
+
+
+//
+// W_PinLump
+// Returns NULL if there's not enough memory for the lump.
+//
+const void __far* W_PinLump(int16_t num)
+{
+	uint8_t count = pincounts[num] & PIN_COUNTMASK;
+
+	if (count == PIN_COUNTMASK)
+		I_Error("W_PinLump: lump %d has too many pins", num);
+
+	// a deferred lump is still in static memory, unless it has been freed
+	if (count == 0 && !((pincounts[num] & PIN_DEFERRED) && lumpcache[num]))
+	{
+		const void __far* ptr = W_TryGetLumpByNum(num);
+		if (ptr == NULL && numdeferredlumps)
+		{
+			W_ReleaseDeferredLumps();
+			ptr = W_TryGetLumpByNum(num);
+		}
+
+		if (ptr == NULL)
+			return NULL;
+	}
+
+	pincounts[num]++;
+	return lumpcache[num];
+}
+
+
+void W_UnpinLump(int16_t num)
+{
+	// a deferred lump stays deferred
+	if (--pincounts[num] != 0)
+		return;
+
+	if (numdeferredlumps < MAXDEFERREDLUMPS)
+	{
+		pincounts[num] = PIN_DEFERRED;
+		deferredlumps[numdeferredlumps++] = num;
+	}
+	else
+		Z_ChangeTagToCache(lumpcache[num]);
+}
+
+
+//
+// W_UnpinFrame
+// Called before the masked stage and at the end of every frame.
+//
+void W_UnpinFrame(void)
+{
+#if defined PINCHECK
+	for (int16_t num = 0; num < numlumps; num++)
+	{
+		if (pincounts[num] & PIN_COUNTMASK)
+			I_Error("W_UnpinFrame: lump %d has %d leaked pins", num, pincounts[num] & PIN_COUNTMASK);
+	}
+#endif
+
+	W_ReleaseDeferredLumps();
+}
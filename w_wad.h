@@ -43,6 +43,7 @@
 void W_Init(void);
 void W_Shutdown(void);
 
+int16_t           PUREFUNC W_CheckNumForName(const char *name);
 int16_t           PUREFUNC W_GetNumForName(const char *name);
 const char __far* PUREFUNC W_GetNameForNum(       int16_t num);
 uint16_t          PUREFUNC W_LumpLength(          int16_t num);
@@ -52,6 +53,10 @@ const void __far* PUREFUNC W_GetLumpByNum(        int16_t num);
 const void __far* PUREFUNC W_TryGetLumpByNum(     int16_t num);
 const void __far* PUREFUNC W_GetLumpByNumAutoFree(int16_t num);
 void                       W_ReadLumpByNum(       int16_t num, void __far* ptr);
+boolean                    W_PrefetchLumpByNum(   int16_t num);
+const void __far*          W_PinLump(             int16_t num);
+void                       W_UnpinLump(           int16_t num);
+void                       W_UnpinFrame(void);
 
 #define W_GetLumpByName(x)    W_GetLumpByNum(W_GetNumForName(x))
 
@@ -46,37 +46,53 @@
 #include "i_system.h"
 
 
+//
+// Every pool holds 32 elements.
+// The pools that have free elements are in a doubly linked list.
+// Full pools aren't in any list, the pool of an element is derived
+// from the element's address. One empty pool is kept around, so
+// allocating and freeing around a multiple of 32 elements doesn't
+// allocate and free a pool every time.
+//
+
 typedef struct bmalpool_s {
 	struct bmalpool_s __far* nextpool;
+	struct bmalpool_s __far* prevpool;
 	uint32_t               used;
 } bmalpool_t;
 
 
-inline static void __far* getelem(bmalpool_t __far* p, size_t size, size_t n)
+#define POOLSIZE	(CHAR_BIT * sizeof(uint32_t))
+#define FULLPOOL	0xffffffff
+
+#if defined _M_I86
+// A pool starts at offset 0 of its segment, see Z_Malloc
+#define ELEMHEADER	0
+
+inline static bmalpool_t __far* getpool(const void __far* p)
 {
-	return ((byte __far*)p) + sizeof(bmalpool_t) + size * n;
+	return D_MK_FP(D_FP_SEG(p), 0);
 }
+#else
+// Every element is preceded by a pointer to its pool
+#define ELEMHEADER	sizeof(bmalpool_t*)
+
+inline static bmalpool_t __far* getpool(const void __far* p)
+{
+	return ((bmalpool_t**)p)[-1];
+}
+#endif
 
 
-inline static PUREFUNC int16_t iselem(const bmalpool_t __far* pool, size_t size, const void __far* p)
+inline static void __far* getelem(bmalpool_t __far* p, size_t size, size_t n)
 {
-#if defined _M_I86
-	if (D_FP_SEG(p) != D_FP_SEG(pool))
-		return -1;
+	return ((byte __far*)p) + sizeof(bmalpool_t) + (ELEMHEADER + size) * n + ELEMHEADER;
+}
 
-	uint16_t dif = D_FP_OFF(p) - D_FP_OFF(pool);
-	dif -= sizeof(bmalpool_t);
-	dif /= size;
-	return dif;
-#else
-	int32_t dif = (const char*)p - (const char*)pool;
-	if (dif < 0)
-		return -1;
 
-	dif -= sizeof(bmalpool_t);
-	dif /= size;
-	return dif >= CHAR_BIT * sizeof(uint32_t) ? -1 : dif;
-#endif
+inline static PUREFUNC int16_t getelemnum(const bmalpool_t __far* pool, size_t size, const void __far* p)
+{
+	return ((const byte __far*)p - ((const byte __far*)pool + sizeof(bmalpool_t) + ELEMHEADER)) / (ELEMHEADER + size);
 }
 
 
@@ -96,50 +112,83 @@ static size_t __builtin_ctzl(uint32_t v)
 #endif
 
 
+static void Z_BLinkPool(struct block_memory_alloc_s *pzone, bmalpool_t __far* pool)
+{
+	pool->prevpool = NULL;
+	pool->nextpool = pzone->firstpool;
+	if (pool->nextpool)
+		pool->nextpool->prevpool = pool;
+	pzone->firstpool = pool;
+}
+
+
+static void Z_BUnlinkPool(struct block_memory_alloc_s *pzone, bmalpool_t __far* pool)
+{
+	if (pool->prevpool)
+		pool->prevpool->nextpool = pool->nextpool;
+	else
+		pzone->firstpool = pool->nextpool;
+
+	if (pool->nextpool)
+		pool->nextpool->prevpool = pool->prevpool;
+}
+
+
 void __far* Z_BMalloc(struct block_memory_alloc_s *pzone)
 {
-	bmalpool_t __far*__far* pool = (bmalpool_t __far*__far*)&(pzone->firstpool);
-	while (*pool != NULL) {
-		if ((*pool)->used == 0xffffffff) {
-			pool = &((*pool)->nextpool);
-		} else {
-			size_t n = __builtin_ctzl(~(*pool)->used);
-			(*pool)->used |= (1UL << n);
-			return getelem(*pool, pzone->size, n);
-		}
+	bmalpool_t __far* pool = pzone->firstpool;
+
+	if (pool == NULL)
+	{
+		// Nothing available, must allocate a new pool
+		// CPhipps: Allocate new memory, initialised to 0
+		pool = Z_CallocLevel(sizeof(bmalpool_t) + (ELEMHEADER + pzone->size) * POOLSIZE);
+
+#if !defined _M_I86
+		for (size_t n = 0; n < POOLSIZE; n++)
+			((bmalpool_t**)getelem(pool, pzone->size, n))[-1] = pool;
+#endif
+
+		Z_BLinkPool(pzone, pool);
 	}
 
-	// Nothing available, must allocate a new pool
-	bmalpool_t __far* newpool;
+	if (pool == pzone->emptypool)
+		pzone->emptypool = NULL;
 
-	// CPhipps: Allocate new memory, initialised to 0
+	size_t n = __builtin_ctzl(~pool->used);
+	pool->used |= (1UL << n);
 
-	*pool = newpool = Z_CallocLevel(sizeof(bmalpool_t) + pzone->size * CHAR_BIT * sizeof(uint32_t));
+	if (pool->used == FULLPOOL)
+		Z_BUnlinkPool(pzone, pool);
 
-	// Return element 0 from this pool to satisfy the request
-	newpool->used = 1;
-	return getelem(newpool, pzone->size, 0);
+	return getelem(pool, pzone->size, n);
 }
 
 
 void Z_BFree(struct block_memory_alloc_s *pzone, void __far* p)
 {
-	bmalpool_t __far*__far* pool = (bmalpool_t __far*__far*)&(pzone->firstpool);
-
-	while (*pool != NULL) {
-		int16_t n = iselem(*pool, pzone->size, p);
-		if (n >= 0) {
-			(*pool)->used &= ~(1UL << n);
-			if ((*pool)->used == 0) {
-				// Block is all unused, can be freed
-				bmalpool_t __far* oldpool = *pool;
-				*pool = (*pool)->nextpool;
-				Z_Free(oldpool);
-			}
-			return;
-		} else
-			pool = &((*pool)->nextpool);
-	}
+	bmalpool_t __far* pool = getpool(p);
+	int16_t n = getelemnum(pool, pzone->size, p);
+
+#if defined RANGECHECK
+	if (n < 0 || n >= (int16_t)POOLSIZE || !(pool->used & (1UL << n)))
+		I_Error("Z_BFree: Free not in zone");
+#endif
+
+	if (pool->used == FULLPOOL)
+		Z_BLinkPool(pzone, pool);
 
-	I_Error("Z_BFree: Free not in zone");
+	pool->used &= ~(1UL << n);
+
+	if (pool->used == 0)
+	{
+		// Block is all unused, keep one of them
+		if (pzone->emptypool == NULL)
+			pzone->emptypool = pool;
+		else
+		{
+			Z_BUnlinkPool(pzone, pool);
+			Z_Free(pool);
+		}
+	}
 }
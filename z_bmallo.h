@@ -34,8 +34,9 @@
  *-----------------------------------------------------------------------------*/
 
 struct block_memory_alloc_s {
-	void  __far* firstpool;
+	struct bmalpool_s __far* firstpool; // pools with free elements
 	size_t size;
+	struct bmalpool_s __far* emptypool; // the empty pool that is kept around
 };
 
 void __far* Z_BMalloc(struct block_memory_alloc_s *pzone);
@@ -23,20 +23,34 @@ bits 16
 extern XMSControl
 
 
+; Query Free Extended Memory
+;
+; output:
+;   ax = size of the largest free block in kibibytes
+
+global Z_QueryFreeExtendedMemory
+Z_QueryFreeExtendedMemory:
+	mov		ah, 08h
+	call	far [XMSControl]
+	retf
+
+
 ; Allocate Extended Memory Block
 ;
 ; input:
 ;   ax = size in kibibytes
 ;
 ; output:
-;   ax = handle
+;   ax = handle, 0 if the allocation failed
 
 global Z_AllocateExtendedMemoryBlock
 Z_AllocateExtendedMemoryBlock:
 	mov		dx, ax
 	mov		ah, 09h
 	call	far [XMSControl]
-	mov		ax, dx
+	neg		ax				; carry is set if ax = 1 (success)
+	sbb		ax, ax
+	and		ax, dx
 	retf
 
 
@@ -29,6 +29,7 @@
 #include "z_zone.h"
 #include "doomdef.h"
 #include "i_system.h"
+#include "globdata.h"
 
 
 //
@@ -48,10 +49,11 @@
 //
 // There is never any space between memblocks,
 //  and there will never be two contiguous free memblocks.
-// The rover can be left pointing at a non-empty block.
 //
 // It is of no value to free a cachable block,
 //  because it will get overwritten automatically if needed.
+// When there is no free block of sufficient size,
+//  the least recently used cachable blocks are purged.
 //
 
 #if defined INSTRUMENTED
@@ -59,33 +61,60 @@
 #endif
 
 
-#define	ZONEID	0x1dea
+// zone statistics, reset every tic by Z_UpdateStats
+static uint16_t stats_allocs;
+static uint16_t stats_frees;
+static uint16_t stats_purges;
+static uint32_t stats_purgedbytes;
+
+
+#define	ZONEID	0xea
 
 typedef struct
 {
 #if SIZE_OF_SEGMENT_T == 2
     uint32_t  size;			// including the header and possibly tiny fragments
-    uint16_t  tag;			// purgelevel
+    uint8_t   tag;			// purgelevel
+#if defined ZONEIDCHECK
+    uint8_t   id;			// should be ZONEID
+#endif
+    uint16_t  lastuse;		// gametic of the last use
 #else
-    uint32_t  size:24;		// including the header and possibly tiny fragments
+    uint32_t  size:20;		// including the header and possibly tiny fragments, see MAXZONESIZE
     uint32_t  tag:4;		// purgelevel
+    uint32_t  lastuse:8;	// gametic of the last use
 #endif
     void __far*__far*    user;	// NULL if a free block
     segment_t next;
     segment_t prev;
-#if defined ZONEIDCHECK
+#if defined ZONEIDCHECK && SIZE_OF_SEGMENT_T != 2
     uint16_t id;			// should be ZONEID
 #endif
 } memblock_t;
 
+// Z_Ticker keeps the ages below MAXAGE + MAXAGE / 2,
+// so they never wrap around
+#if SIZE_OF_SEGMENT_T == 2
+#define LASTUSE_MASK 0xffff
+#define MAXAGE       0x8000
+#else
+#define LASTUSE_MASK 0xff
+#define MAXAGE       0x80
+#endif
+
+#define Z_Age(block, now) (((now) - (block)->lastuse) & LASTUSE_MASK)
+
 
 #define PARAGRAPH_SIZE 16
 
 typedef char assertMemblockSize[sizeof(memblock_t) <= PARAGRAPH_SIZE ? 1 : -1];
 
+#if SIZE_OF_SEGMENT_T != 2
+#define MAXZONESIZE ((((uint32_t)1) << 20) - PARAGRAPH_SIZE)	// the largest size that fits in memblock_t.size
+#endif
+
 
 static memblock_t __far* mainzone_sentinal;
-static segment_t   mainzone_rover_segment;
 
 
 static segment_t pointerToSegment(const memblock_t __far* ptr)
@@ -104,6 +133,113 @@ static memblock_t __far* segmentToPointer(segment_t seg)
 }
 
 
+//
+// Segregated free lists
+//
+// Next to the block chain, every free block of at least two paragraphs
+// is linked into a size class list.
+// Size class n holds the free blocks of 2^n up to 2^(n+1)-1 paragraphs.
+// The links are stored in the first paragraph after the block header.
+//
+
+#define NUMBINS 16
+
+typedef struct
+{
+	segment_t next;
+	segment_t prev;
+} freelinks_t;
+
+static segment_t freebins[NUMBINS];
+
+
+static freelinks_t __far* segmentToFreeLinks(segment_t seg)
+{
+	return D_MK_FP(seg + 1, 0);
+}
+
+
+static uint_fast8_t Z_GetBin(uint32_t size)
+{
+	uint16_t paragraphs = size / PARAGRAPH_SIZE;
+
+	uint_fast8_t bin = 0;
+	while (paragraphs >>= 1)
+		bin++;
+
+	return bin;
+}
+
+
+static void Z_LinkFreeBlock(memblock_t __far* block)
+{
+	if (block->size < 2 * PARAGRAPH_SIZE)
+		return; // no room for the links
+
+	segment_t block_segment = pointerToSegment(block);
+	uint_fast8_t bin = Z_GetBin(block->size);
+
+	freelinks_t __far* links = segmentToFreeLinks(block_segment);
+	links->next = freebins[bin];
+	links->prev = 0;
+
+	if (freebins[bin])
+		segmentToFreeLinks(freebins[bin])->prev = block_segment;
+
+	freebins[bin] = block_segment;
+}
+
+
+static void Z_UnlinkFreeBlock(memblock_t __far* block)
+{
+	if (block->size < 2 * PARAGRAPH_SIZE)
+		return; // was never linked
+
+	const freelinks_t __far* links = segmentToFreeLinks(pointerToSegment(block));
+
+	if (links->prev)
+		segmentToFreeLinks(links->prev)->next = links->next;
+	else
+		freebins[Z_GetBin(block->size)] = links->next;
+
+	if (links->next)
+		segmentToFreeLinks(links->next)->prev = links->prev;
+}
+
+
+//
+// Z_FindFreeBlock
+// Best fit within the size class of the requested size,
+// otherwise the first block of the next non-empty size class.
+//
+static memblock_t __far* Z_FindFreeBlock(uint32_t size)
+{
+	uint_fast8_t bin = Z_GetBin(size);
+
+	memblock_t __far* best = NULL;
+	for (segment_t seg = freebins[bin]; seg; seg = segmentToFreeLinks(seg)->next)
+	{
+		memblock_t __far* block = segmentToPointer(seg);
+		if (block->size >= size && (!best || block->size < best->size))
+		{
+			best = block;
+			if (block->size == size)
+				break;
+		}
+	}
+
+	if (best)
+		return best;
+
+	// every block in a larger size class is big enough
+	for (bin++; bin < NUMBINS; bin++)
+		if (freebins[bin])
+			return segmentToPointer(freebins[bin]);
+
+	return NULL;
+}
+
+
 boolean Z_EqualNames(const char __far* farName, const char* nearName)
 {
 	return _fmemcmp(farName, nearName, 8) == 0;
@@ -120,7 +256,20 @@ boolean Z_EqualNames(const char __far* farName, const char* nearName)
 #define	EMS_FREEPAGES	0x45
 #define	EMS_VERSION		0x46
 
+#define EMS_PAGE_SIZE		16384
+#define EMS_ZONE_PAGES		4
+#define EMS_MAX_CACHE_PAGES	128
+#define EMS_WINDOW_PAGE		(EMS_ZONE_PAGES - 1)
+
 static uint16_t emsHandle;
+static memblock_t __far* emsblock;
+static segment_t emsWindowSegment;
+
+// logical pages after the first EMS_ZONE_PAGES pages, for the lump cache
+static uint16_t emsCachePages;
+
+// the logical page that is mapped into the window, -1 if none
+static int16_t emsMappedPage;
 
 static segment_t Z_InitExpandedMemory(void)
 {
@@ -161,22 +310,36 @@ static segment_t Z_InitExpandedMemory(void)
 
 	regs.h.ah = EMS_GETPAGES;
 	int86(EMS_INT, &regs, &regs);
-	if (regs.h.ah || regs.w.bx < 4)
+	if (regs.h.ah || regs.w.bx < EMS_ZONE_PAGES)
 		return 0;
 
-	// There are at least 4 unallocated pages
+	// There are at least 4 unallocated pages,
+	// the pages after the first 4 are used for the lump cache
+	uint16_t pages = regs.w.bx;
+	if (pages > EMS_ZONE_PAGES + EMS_MAX_CACHE_PAGES)
+		pages = EMS_ZONE_PAGES + EMS_MAX_CACHE_PAGES;
 
 	regs.h.ah = EMS_ALLOCPAGES;
-	regs.w.bx = 4;
+	regs.w.bx = pages;
 	int86(EMS_INT, &regs, &regs);
 	if (regs.h.ah)
-		return 0;
+	{
+		pages = EMS_ZONE_PAGES;
+
+		regs.h.ah = EMS_ALLOCPAGES;
+		regs.w.bx = pages;
+		int86(EMS_INT, &regs, &regs);
+		if (regs.h.ah)
+			return 0;
+	}
 
-	// 4 logical pages are allocated
+	// the logical pages are allocated
 
 	emsHandle = regs.w.dx;
+	emsCachePages = pages - EMS_ZONE_PAGES;
+	emsMappedPage = -1;
 
-	for (int16_t pageNumber = 0; pageNumber < 4; pageNumber++)
+	for (int16_t pageNumber = 0; pageNumber < EMS_ZONE_PAGES; pageNumber++)
 	{
 		regs.h.ah = EMS_MAPPAGE;
 		regs.h.al = pageNumber;	// physical page number
@@ -220,6 +383,7 @@ static ExtMemMoveStruct_t ExtMemMoveStruct;
 
 #if defined _M_I86
 #if !defined C_ONLY
+uint16_t Z_QueryFreeExtendedMemory(void);
 uint16_t Z_AllocateExtendedMemoryBlock(uint16_t size);
 void Z_FreeExtendedMemoryBlock(uint16_t handle);
 void Z_MoveExtendedMemoryBlock(const ExtMemMoveStruct_t __far* s);
@@ -252,10 +416,15 @@ static void Z_MoveExtendedMemoryBlock(const ExtMemMoveStruct_t __far* s)
 #endif
 
 
-boolean Z_InitXms(uint32_t size)
+//
+// Z_InitXms
+// Allocates size bytes of XMS, or less if there isn't enough XMS available.
+// Returns the number of bytes allocated.
+//
+uint32_t Z_InitXms(uint32_t size)
 {
 	if (M_CheckParm("-noxms"))
-		return false;
+		return 0;
 
 #if defined _M_I86
 #if !defined C_ONLY
@@ -266,7 +435,7 @@ boolean Z_InitXms(uint32_t size)
 	regs.w.ax = XMS_INSTALLATION_CHECK;
 	int86(XMS_INT, &regs, &regs);
 	if (regs.h.al != 0x80)
-		return false;
+		return 0;
 
 	// Get the address of the driver's control function
 	regs.w.ax = XMS_GET_DRIVER_ADDRESS;
@@ -275,17 +444,25 @@ boolean Z_InitXms(uint32_t size)
 
 	// Allocate Extended Memory Block
 	uint16_t xmsSize = (size + (1024 - 1)) / 1024;
+
+	uint16_t largestFreeXmsSize = Z_QueryFreeExtendedMemory();
+	if (xmsSize > largestFreeXmsSize)
+		xmsSize = largestFreeXmsSize;
+
+	if (xmsSize == 0)
+		return 0;
+
 	xmsHandle = Z_AllocateExtendedMemoryBlock(xmsSize);
 
-	return xmsHandle != 0;
+	return xmsHandle ? xmsSize * 1024L : 0;
 #else
 	UNUSED(size);
-	return false;
+	return 0;
 #endif
 #else
 	xmsHandle = 1;
 	fakeXMSHandle = malloc(size);
-	return fakeXMSHandle != NULL;
+	return fakeXMSHandle ? size : 0;
 #endif
 }
 
@@ -312,8 +489,16 @@ void Z_MoveExtendedMemoryToConventionalMemory(void __far* dest, uint32_t src, ui
 }
 
 
+static FILE* statsfile;
+
 void Z_Shutdown(void)
 {
+	if (statsfile)
+	{
+		fclose(statsfile);
+		statsfile = NULL;
+	}
+
 	if (emsHandle)
 	{
 		union REGS regs;
@@ -359,6 +544,17 @@ static unsigned int _dos_allocmem(unsigned int __size, unsigned int *__seg)
 #endif
 
 
+#if !defined _M_I86
+// Lumps can point straight into the WAD file in memory, see W_Init
+static const uint8_t* zonestart;
+static const uint8_t* zoneend;
+
+#define Z_IsInZone(ptr) (zonestart <= (const uint8_t*)(ptr) && (const uint8_t*)(ptr) < zoneend)
+#else
+#define Z_IsInZone(ptr) true
+#endif
+
+
 //
 // Z_Init
 //
@@ -372,6 +568,14 @@ void Z_Init (void)
 
 	uint32_t heapSize = (uint32_t)max * PARAGRAPH_SIZE;
 
+#if !defined _M_I86
+	if (heapSize > MAXZONESIZE)
+		heapSize = MAXZONESIZE;
+
+	zonestart = mainzone;
+	zoneend   = mainzone + heapSize;
+#endif
+
 	printf("Standard: %ld bytes\n", heapSize);
 
 	// align blocklist
@@ -389,12 +593,12 @@ void Z_Init (void)
 
 	// set the entire zone to one free block
 	memblock_t __far* block = (memblock_t __far*)mainzone;
-	mainzone_rover_segment = pointerToSegment(block);
+	segment_t block_segment = pointerToSegment(block);
 
 	mainzone_sentinal->tag  = PU_STATIC;
 	mainzone_sentinal->user = (void __far*)mainzone;
-	mainzone_sentinal->next = mainzone_rover_segment;
-	mainzone_sentinal->prev = mainzone_rover_segment;
+	mainzone_sentinal->next = block_segment;
+	mainzone_sentinal->prev = block_segment;
 
 	block->size = heapSize;
 	block->tag  = 0;
@@ -408,18 +612,19 @@ void Z_Init (void)
 	segment_t ems_segment = Z_InitExpandedMemory();
 	if (ems_segment)
 	{
-		segment_t romblock_segment = mainzone_rover_segment + heapSize / PARAGRAPH_SIZE - 1;
+
+		segment_t romblock_segment = block_segment + heapSize / PARAGRAPH_SIZE - 1;
 		memblock_t __far* romblock = segmentToPointer(romblock_segment);
 		romblock->size = (uint32_t)(ems_segment - romblock_segment) * PARAGRAPH_SIZE;
 		romblock->tag  = PU_STATIC;
 		romblock->user = (void __far*)mainzone;
 		romblock->next = ems_segment;
-		romblock->prev = mainzone_rover_segment;
+		romblock->prev = block_segment;
 #if defined ZONEIDCHECK
 		romblock->id   = ZONEID;
 #endif
 
-		memblock_t __far* emsblock = segmentToPointer(ems_segment);
+		emsblock = segmentToPointer(ems_segment);
 		emsblock->size = 65536;
 		emsblock->tag  = 0;
 		emsblock->user = NULL; // NULL indicates a free block.
@@ -433,16 +638,110 @@ void Z_Init (void)
 		block->next = romblock_segment;
 		printf("Expanded:  65536 bytes\n");
 		heapSize += 65536 - PARAGRAPH_SIZE;
+
+		Z_LinkFreeBlock(emsblock);
 	}
 	else
 		printf("Expanded:      0 bytes\n");
 
+	Z_LinkFreeBlock(block);
+
 	printf("%ld bytes allocated for zone\n", heapSize);
 }
 
 
+//
+// EMS lump cache
+//
+// The logical EMS pages after the first 4 pages
+// are mapped one at a time into the last physical page.
+// Physical page 3 is taken from the zone,
+// so this is only possible while the EMS block is still unused.
+//
+uint32_t Z_InitExpandedMemoryCache(void)
+{
+	if (!emsCachePages || M_CheckParm("-noemscache"))
+		return 0;
+
+	if (emsblock->user || emsblock->size != (uint32_t)EMS_ZONE_PAGES * EMS_PAGE_SIZE)
+		return 0;
+
+	// the EMS block is the last block, so it can shrink
+	Z_UnlinkFreeBlock(emsblock);
+	emsblock->size -= EMS_PAGE_SIZE;
+	Z_LinkFreeBlock(emsblock);
+
+	emsWindowSegment = pointerToSegment(emsblock) + EMS_WINDOW_PAGE * (EMS_PAGE_SIZE / PARAGRAPH_SIZE);
+
+	return (uint32_t)emsCachePages * EMS_PAGE_SIZE;
+}
+
+
+static void Z_MapExpandedMemoryPage(int16_t page)
+{
+	if (page == emsMappedPage)
+		return;
+
+	union REGS regs;
+	regs.h.ah = EMS_MAPPAGE;
+	regs.h.al = EMS_WINDOW_PAGE;			// physical page number
+	regs.w.bx = EMS_ZONE_PAGES + page;		//  logical page number
+	regs.w.dx = emsHandle;
+	int86(EMS_INT, &regs, &regs);
+	if (regs.h.ah)
+		I_Error("Z_MapExpandedMemoryPage: failed to map page %i", page);
+
+	emsMappedPage = page;
+}
+
+
+void Z_MoveConventionalMemoryToExpandedMemory(uint32_t dest, const void __far* src, uint16_t length)
+{
+	const uint8_t __far* s = src;
+
+	while (length)
+	{
+		uint16_t offset = dest & (EMS_PAGE_SIZE - 1);
+		uint16_t count  = EMS_PAGE_SIZE - offset;
+		if (count > length)
+			count = length;
+
+		Z_MapExpandedMemoryPage(dest / EMS_PAGE_SIZE);
+		_fmemcpy(D_MK_FP(emsWindowSegment, offset), s, count);
+
+		s      += count;
+		dest   += count;
+		length -= count;
+	}
+}
+
+
+void Z_MoveExpandedMemoryToConventionalMemory(void __far* dest, uint32_t src, uint16_t length)
+{
+	uint8_t __far* d = dest;
+
+	while (length)
+	{
+		uint16_t offset = src & (EMS_PAGE_SIZE - 1);
+		uint16_t count  = EMS_PAGE_SIZE - offset;
+		if (count > length)
+			count = length;
+
+		Z_MapExpandedMemoryPage(src / EMS_PAGE_SIZE);
+		_fmemcpy(d, D_MK_FP(emsWindowSegment, offset), count);
+
+		d      += count;
+		src    += count;
+		length -= count;
+	}
+}
+
+
 static void Z_ChangeTag(const void __far* ptr, uint_fast8_t tag)
 {
+	if (!Z_IsInZone(ptr))
+		return;
+
 #if defined RANGECHECK
 	if ((((uint32_t) ptr) & (PARAGRAPH_SIZE - 1)) != 0)
 		I_Error("Z_ChangeTag: pointer is not aligned: 0x%lx", ptr);
@@ -458,7 +757,8 @@ static void Z_ChangeTag(const void __far* ptr, uint_fast8_t tag)
 	if (block->id != ZONEID)
 		I_Error("Z_ChangeTag: block has id %x instead of ZONEID", block->id);
 #endif
-	block->tag = tag;
+	block->tag     = tag;
+	block->lastuse = _g_gametic;
 }
 
 
@@ -474,6 +774,25 @@ void Z_ChangeTagToCache(const void __far* ptr)
 }
 
 
+// The block no longer belongs to its user,
+// it's freed when the level is exited.
+void Z_ChangeTagToLevel(const void __far* ptr)
+{
+	if (!Z_IsInZone(ptr))
+		return;
+
+	Z_ChangeTag(ptr, PU_LEVEL);
+
+#if defined _M_I86
+	memblock_t __far* block = (memblock_t __far*)(((uint32_t)ptr) - 0x00010000);
+#else
+	memblock_t __far* block = (memblock_t __far*)(((uint32_t)ptr) - 0x00010);
+#endif
+
+	block->user = (void __far*__far*) D_MK_FP(0,2); // unowned
+}
+
+
 static void Z_FreeBlock(memblock_t __far* block)
 {
 #if defined ZONEIDCHECK
@@ -505,13 +824,11 @@ static void Z_FreeBlock(memblock_t __far* block)
     if (!other->user)
     {
         // merge with previous free block
+        Z_UnlinkFreeBlock(other);
         other->size += block->size;
         other->next  = block->next;
         segmentToPointer(other->next)->prev = block->prev; // == pointerToSegment(other);
 
-        if (pointerToSegment(block) == mainzone_rover_segment)
-            mainzone_rover_segment = block->prev; // == pointerToSegment(other);
-
         block = other;
     }
 
@@ -519,13 +836,13 @@ static void Z_FreeBlock(memblock_t __far* block)
     if (!other->user)
     {
         // merge the next free block onto the end
+        Z_UnlinkFreeBlock(other);
         block->size += other->size;
         block->next  = other->next;
         segmentToPointer(block->next)->prev = pointerToSegment(block);
-
-        if (pointerToSegment(other) == mainzone_rover_segment)
-            mainzone_rover_segment = pointerToSegment(block);
     }
+
+    Z_LinkFreeBlock(block);
 }
 
 
@@ -534,6 +851,9 @@ static void Z_FreeBlock(memblock_t __far* block)
 //
 void Z_Free (const void __far* ptr)
 {
+	if (!Z_IsInZone(ptr))
+		return;
+
 #if defined RANGECHECK
 	if ((((uint32_t) ptr) & (PARAGRAPH_SIZE - 1)) != 0)
 		I_Error("Z_Free: pointer is not aligned: 0x%lx", ptr);
@@ -545,6 +865,7 @@ void Z_Free (const void __far* ptr)
 	memblock_t __far* block = (memblock_t __far*)(((uint32_t)ptr) - 0x00010);
 #endif
 
+	stats_frees++;
 	Z_FreeBlock(block);
 }
 
@@ -562,7 +883,7 @@ static uint32_t Z_GetLargestFreeBlockSize(void)
 	return largestFreeBlockSize;
 }
 
-static uint32_t Z_GetTotalFreeMemory(void)
+uint32_t Z_GetTotalFreeMemory(void)
 {
 	uint32_t totalFreeMemory = 0;
 
@@ -576,6 +897,126 @@ static uint32_t Z_GetTotalFreeMemory(void)
 }
 
 
+//
+// Z_FindPurgeRun
+// Returns the first run of contiguous free blocks
+// and purgable blocks of at least minage tics old
+// of sufficient size.
+// If maxage isn't NULL, the whole zone is scanned
+// and *maxage is set to the age of the oldest purgable block.
+//
+static memblock_t __far* Z_FindPurgeRun(uint32_t size, uint16_t minage, uint16_t* maxage)
+{
+    uint16_t now = _g_gametic;
+
+    memblock_t __far* found = NULL;
+    memblock_t __far* start = NULL;
+    uint32_t run_size = 0;
+
+    if (maxage)
+        *maxage = 0;
+
+    segment_t mainzone_sentinal_segment = pointerToSegment(mainzone_sentinal);
+
+    for (memblock_t __far* block = segmentToPointer(mainzone_sentinal->next); pointerToSegment(block) != mainzone_sentinal_segment; block = segmentToPointer(block->next))
+    {
+        if (block->user)
+        {
+            if (block->tag < PU_PURGELEVEL)
+            {
+                // hit a block that can't be purged
+                start = NULL;
+                continue;
+            }
+
+            uint16_t age = Z_Age(block, now);
+            if (maxage && age > *maxage)
+                *maxage = age;
+
+            if (age < minage)
+            {
+                // used too recently
+                start = NULL;
+                continue;
+            }
+        }
+
+        if (!start)
+        {
+            start    = block;
+            run_size = 0;
+        }
+
+        run_size += block->size;
+        if (run_size >= size && !found)
+        {
+            found = start;
+            if (!maxage)
+                break;
+        }
+    }
+
+    return found;
+}
+
+
+//
+// Z_PurgeCache
+// Looks for a run of contiguous free and purgable blocks
+// of sufficient size whose most recently used block
+// was used the longest time ago,
+// and throws out the purgable blocks of that run.
+// That age is found one bit at a time,
+// with a linear pass over the zone per bit.
+//
+static memblock_t __far* Z_PurgeCache(uint32_t size)
+{
+    uint16_t maxage;
+    memblock_t __far* best = Z_FindPurgeRun(size, 0, &maxage);
+    if (!best)
+        return NULL;
+
+    uint16_t bit = MAXAGE;
+    while (bit > maxage)
+        bit >>= 1;
+
+    uint16_t best_age = 0;
+    for (; bit; bit >>= 1)
+    {
+        memblock_t __far* run = Z_FindPurgeRun(size, best_age | bit, NULL);
+        if (run)
+        {
+            best      = run;
+            best_age |= bit;
+        }
+    }
+
+    // a free block in front of the run becomes part of it
+    memblock_t __far* base     = best;
+    memblock_t __far* previous = segmentToPointer(base->prev);
+    if (!previous->user)
+    {
+        base     = previous;
+        previous = segmentToPointer(base->prev);
+    }
+
+    // free the purgable blocks of the run (adding the size to base),
+    // previous is in use, so it won't be merged
+    while (base->user || base->size < size)
+    {
+        memblock_t __far* block = base->user ? base : segmentToPointer(base->next);
+
+        stats_purges++;
+        stats_purgedbytes += block->size;
+
+        Z_FreeBlock(block);
+        base = segmentToPointer(previous->next);
+    }
+
+    return base;
+}
+
+
 //
 // Z_TryMalloc
 // You can pass a NULL user if the tag is < PU_PURGELEVEL.
@@ -588,64 +1029,27 @@ static void __far* Z_TryMalloc(uint16_t size, int8_t tag, void __far*__far* user
 {
     size = (size + (PARAGRAPH_SIZE - 1)) & ~(PARAGRAPH_SIZE - 1);
 
-    // scan through the block list,
-    // looking for the first free block
-    // of sufficient size,
-    // throwing out any purgable blocks along the way.
-
     // account for size of block header
-    size += PARAGRAPH_SIZE;
-
-    // if there is a free block behind the rover,
-    //  back up over them
-    memblock_t __far* base = segmentToPointer(mainzone_rover_segment);
-
-    memblock_t __far* previous_block = segmentToPointer(base->prev);
-    if (!previous_block->user)
-        base = previous_block;
+    uint32_t blocksize = size + PARAGRAPH_SIZE;
 
-    memblock_t __far* rover   = base;
-    segment_t   start_segment = base->prev;
-
-    do
+    // look for a free block in the size class lists first,
+    // only throw out purgable blocks when that fails
+    memblock_t __far* base = Z_FindFreeBlock(blocksize);
+    if (!base)
     {
-        if (pointerToSegment(rover) == start_segment)
-        {
-            // scanned all the way around the list
+        base = Z_PurgeCache(blocksize);
+        if (!base)
             return NULL;
-        }
-
-        if (rover->user)
-        {
-            if (rover->tag < PU_PURGELEVEL)
-            {
-                // hit a block that can't be purged,
-                //  so move base past it
-                base = rover = segmentToPointer(rover->next);
-            }
-            else
-            {
-                // free the rover block (adding the size to base)
-
-                // the rover can be the base block
-                base  = segmentToPointer(base->prev);
-                Z_FreeBlock(rover);
-                base  = segmentToPointer(base->next);
-                rover = segmentToPointer(base->next);
-            }
-        }
-        else
-            rover = segmentToPointer(rover->next);
+    }
 
-    } while (base->user || base->size < size);
-    // found a block big enough
+    Z_UnlinkFreeBlock(base);
 
-    int32_t newblock_size = base->size - size;
+    int32_t newblock_size = base->size - blocksize;
     if (newblock_size > MINFRAGMENT)
     {
         // there will be a free fragment after the allocated block
         segment_t base_segment     = pointerToSegment(base);
-        segment_t newblock_segment = base_segment + (size / PARAGRAPH_SIZE);
+        segment_t newblock_segment = base_segment + (blocksize / PARAGRAPH_SIZE);
 
         memblock_t __far* newblock = segmentToPointer(newblock_segment);
         newblock->size = newblock_size;
@@ -658,11 +1062,15 @@ static void __far* Z_TryMalloc(uint16_t size, int8_t tag, void __far*__far* user
 #endif
 
         segmentToPointer(base->next)->prev = newblock_segment;
-        base->size = size;
+        base->size = blocksize;
         base->next = newblock_segment;
+
+        Z_LinkFreeBlock(newblock);
     }
 
-    base->tag  = tag;
+    base->tag     = tag;
+    base->lastuse = _g_gametic;
+    stats_allocs++;
     if (user)
         base->user = user;
     else
@@ -671,9 +1079,6 @@ static void __far* Z_TryMalloc(uint16_t size, int8_t tag, void __far*__far* user
     base->id  = ZONEID;
 #endif
 
-    // next allocation will start looking here
-    mainzone_rover_segment = base->next;
-
 #if defined INSTRUMENTED
     running_count += base->size;
     printf("Alloc: %ld (%ld)\n", base->size, running_count);
@@ -737,6 +1142,90 @@ void __far* Z_CallocLevSpec(uint16_t size)
 }
 
 
+//
+// Level arena
+// P_SetupLevel allocates the level data from one PU_LEVEL block,
+// paragraph aligned and without a block header per allocation.
+// Z_FreeTags frees the whole arena at once.
+//
+
+static memblock_t __far* arenablock; // NULL if there's no arena
+static segment_t arenanext;
+static segment_t arenaend;
+
+void Z_InitLevelArena(uint32_t size)
+{
+	if (size > 0xfff0)
+		size = 0xfff0;
+
+	uint8_t __far* ptr = Z_TryMalloc(size, PU_LEVEL, NULL);
+	if (!ptr)
+	{
+		// everything goes to separate blocks
+		arenablock = NULL;
+		arenanext  = arenaend = 0;
+		return;
+	}
+
+	arenablock = (memblock_t __far*)(ptr - PARAGRAPH_SIZE);
+	arenanext  = D_FP_SEG(ptr);
+	arenaend   = pointerToSegment(arenablock) + (arenablock->size / PARAGRAPH_SIZE);
+}
+
+
+void __far* Z_MallocArena(uint16_t size)
+{
+	segment_t paragraphs = (size + (PARAGRAPH_SIZE - 1)) / PARAGRAPH_SIZE;
+	if (arenaend - arenanext < paragraphs)
+		return Z_MallocLevel(size, NULL);
+
+	void __far* ptr = segmentToPointer(arenanext);
+	arenanext += paragraphs;
+	return ptr;
+}
+
+
+void __far* Z_CallocArena(uint16_t size)
+{
+	void __far* ptr = Z_MallocArena(size);
+	_fmemset(ptr, 0, size);
+	return ptr;
+}
+
+
+// Gives the unused end of the arena back to the zone
+void Z_TrimLevelArena(void)
+{
+	if (!arenablock)
+		return;
+
+	segment_t arenasegment = pointerToSegment(arenablock);
+	uint32_t  blocksize    = (uint32_t)(arenanext - arenasegment) * PARAGRAPH_SIZE;
+	int32_t   tailsize     = arenablock->size - blocksize;
+	if (tailsize > MINFRAGMENT)
+	{
+		memblock_t __far* tail = segmentToPointer(arenanext);
+		tail->size = tailsize;
+		tail->tag  = PU_LEVEL;
+		tail->user = (void __far*__far*) D_MK_FP(0,2); // unowned
+		tail->next = arenablock->next;
+		tail->prev = arenasegment;
+#if defined ZONEIDCHECK
+		tail->id   = ZONEID;
+#endif
+
+		segmentToPointer(arenablock->next)->prev = arenanext;
+		arenablock->size = blocksize;
+		arenablock->next = arenanext;
+
+		// merges the tail with the next block if that one is free
+		Z_FreeBlock(tail);
+	}
+
+	arenaend = arenanext;
+}
+
+
 boolean Z_IsEnoughFreeMemory(uint16_t size)
 {
 	const uint8_t __far* ptr = Z_TryMallocStatic(size);
@@ -749,6 +1238,15 @@ boolean Z_IsEnoughFreeMemory(uint16_t size)
 }
 
 
+
+// Like Z_IsEnoughFreeMemory, but without throwing out purgable blocks
+boolean Z_IsFreeBlockAvailable(uint16_t size)
+{
+	uint32_t blocksize = ((size + (PARAGRAPH_SIZE - 1)) & ~(PARAGRAPH_SIZE - 1)) + PARAGRAPH_SIZE;
+	return Z_FindFreeBlock(blocksize) != NULL;
+}
+
+
 //
 // Z_FreeTags
 //
@@ -768,8 +1266,15 @@ void Z_FreeTags(void)
             continue;
 
         if (PU_LEVEL <= block->tag && block->tag <= (PU_PURGELEVEL - 1))
+        {
+            stats_frees++;
             Z_FreeBlock(block);
+        }
     }
+
+    // the level arena is gone too
+    arenablock = NULL;
+    arenanext  = arenaend = 0;
 }
 
 //
@@ -801,4 +1306,143 @@ void Z_CheckHeap (void)
         if (!block->user && !segmentToPointer(block->next)->user)
             I_Error ("Z_CheckHeap: two consecutive free blocks\n");
     }
+
+    uint16_t linkedBlocks = 0;
+
+    for (memblock_t __far* block = segmentToPointer(mainzone_sentinal->next); pointerToSegment(block) != mainzone_sentinal_segment; block = segmentToPointer(block->next))
+        if (!block->user && block->size >= 2 * PARAGRAPH_SIZE)
+            linkedBlocks++;
+
+    for (uint_fast8_t bin = 0; bin < NUMBINS; bin++)
+    {
+        segment_t prev = 0;
+
+        for (segment_t seg = freebins[bin]; seg; seg = segmentToFreeLinks(seg)->next)
+        {
+            const memblock_t __far* block = segmentToPointer(seg);
+
+            if (block->user)
+                I_Error ("Z_CheckHeap: used block in a size class list\n");
+
+            if (Z_GetBin(block->size) != bin)
+                I_Error ("Z_CheckHeap: free block in the wrong size class list\n");
+
+            if (segmentToFreeLinks(seg)->prev != prev)
+                I_Error ("Z_CheckHeap: free block doesn't have proper back link\n");
+
+            prev = seg;
+            linkedBlocks--;
+        }
+    }
+
+    if (linkedBlocks != 0)
+        I_Error ("Z_CheckHeap: size class lists don't match the free blocks\n");
+}
+
+
+//
+// Zone statistics
+//
+// With -zonestats, a line per tic is written to ZONESTAT.CSV with
+// the bytes in use per tag, the free memory, the largest free block,
+// the number of allocations, frees and purges, the bytes purged
+// and the number of free blocks per size class.
+//
+
+#define ZONESTATS_FILE "ZONESTAT.CSV"
+
+static char statstext[35];
+
+
+void Z_InitStats(void)
+{
+	if (!M_CheckParm("-zonestats"))
+		return;
+
+	statsfile = fopen(ZONESTATS_FILE, "w");
+	if (statsfile == NULL)
+		I_Error("Z_InitStats: Can't open " ZONESTATS_FILE);
+
+	fprintf(statsfile, "gametic,static,level,levspec,cache,free,largest,allocs,frees,purges,purgedbytes");
+	for (uint_fast8_t bin = 1; bin < NUMBINS; bin++)
+		fprintf(statsfile, ",bin%u", 1 << bin);
+	fprintf(statsfile, "\n");
+}
+
+
+//
+// Z_Ticker
+// Every MAXAGE / 2 tics the blocks older than MAXAGE
+// are made MAXAGE tics old, so their ages can't wrap around.
+//
+void Z_Ticker(void)
+{
+    if (_g_gametic & (MAXAGE / 2 - 1))
+        return;
+
+    uint16_t now = _g_gametic;
+
+    segment_t mainzone_sentinal_segment = pointerToSegment(mainzone_sentinal);
+
+    for (memblock_t __far* block = segmentToPointer(mainzone_sentinal->next); pointerToSegment(block) != mainzone_sentinal_segment; block = segmentToPointer(block->next))
+    {
+        if (block->user && Z_Age(block, now) > MAXAGE)
+            block->lastuse = now - MAXAGE;
+    }
+}
+
+
+void Z_UpdateStats(void)
+{
+	if (!statsfile)
+		return;
+
+	uint32_t tagbytes[PU_CACHE + 1];
+	for (uint_fast8_t tag = 0; tag <= PU_CACHE; tag++)
+		tagbytes[tag] = 0;
+
+	uint32_t largestFreeBlockSize = 0;
+
+	segment_t mainzone_sentinal_segment = pointerToSegment(mainzone_sentinal);
+
+	for (const memblock_t __far* block = segmentToPointer(mainzone_sentinal->next); pointerToSegment(block) != mainzone_sentinal_segment; block = segmentToPointer(block->next))
+	{
+		if (!block->user)
+		{
+			tagbytes[0] += block->size;
+			if (block->size > largestFreeBlockSize)
+				largestFreeBlockSize = block->size;
+		}
+		else
+			tagbytes[block->tag] += block->size;
+	}
+
+	fprintf(statsfile, "%ld,%ld,%ld,%ld,%ld,%ld,%ld,%u,%u,%u,%ld",
+		_g_gametic,
+		tagbytes[PU_STATIC], tagbytes[PU_LEVEL], tagbytes[PU_LEVSPEC], tagbytes[PU_CACHE],
+		tagbytes[0], largestFreeBlockSize,
+		stats_allocs, stats_frees, stats_purges, stats_purgedbytes);
+
+	for (uint_fast8_t bin = 1; bin < NUMBINS; bin++)
+	{
+		uint16_t count = 0;
+		for (segment_t seg = freebins[bin]; seg; seg = segmentToFreeLinks(seg)->next)
+			count++;
+
+		fprintf(statsfile, ",%u", count);
+	}
+	fprintf(statsfile, "\n");
+
+	sprintf(statstext, "FREE %3ldK MAX %3ldK CACHE %3ldK", tagbytes[0] / 1024, largestFreeBlockSize / 1024, tagbytes[PU_CACHE] / 1024);
+
+	stats_allocs      = 0;
+	stats_frees       = 0;
+	stats_purges      = 0;
+	stats_purgedbytes = 0;
+}
+
+
+const char* Z_GetStatsText(void)
+{
+	return statsfile ? statstext : NULL;
 }
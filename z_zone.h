@@ -30,23 +30,39 @@
 #include "doomtype.h"
 
 void Z_Init(void);
-boolean Z_InitXms(uint32_t size);
+uint32_t Z_InitXms(uint32_t size);
 void Z_MoveConventionalMemoryToExtendedMemory(uint32_t dest, const void __far* src, uint16_t length);
 void Z_MoveExtendedMemoryToConventionalMemory(void __far* dest, uint32_t src, uint16_t length);
+uint32_t Z_InitExpandedMemoryCache(void);
+void Z_MoveConventionalMemoryToExpandedMemory(uint32_t dest, const void __far* src, uint16_t length);
+void Z_MoveExpandedMemoryToConventionalMemory(void __far* dest, uint32_t src, uint16_t length);
 void Z_Shutdown(void);
 boolean Z_IsEnoughFreeMemory(uint16_t size);
+boolean Z_IsFreeBlockAvailable(uint16_t size);
+uint32_t Z_GetTotalFreeMemory(void);
 void __far* Z_TryMallocStatic(uint16_t size);
 void __far* Z_MallocStatic(uint16_t size);
 void __far* Z_MallocStaticWithUser(uint16_t size, void __far*__far* user); 
 void __far* Z_MallocLevel(uint16_t size, void __far*__far* user);
 void __far* Z_CallocLevel(uint16_t size);
 void __far* Z_CallocLevSpec(uint16_t size);
+void Z_InitLevelArena(uint32_t size);
+void __far* Z_MallocArena(uint16_t size);
+void __far* Z_CallocArena(uint16_t size);
+void Z_TrimLevelArena(void);
 void Z_ChangeTagToStatic(const void __far* ptr);
 void Z_ChangeTagToCache(const void __far* ptr);
+void Z_ChangeTagToLevel(const void __far* ptr);
 void Z_Free(const void __far* ptr);
 void Z_FreeTags(void);
 void Z_CheckHeap(void);
 
+void Z_InitStats(void);
+void Z_UpdateStats(void);
+
+void Z_Ticker(void);
+const char* Z_GetStatsText(void);
+
 boolean Z_EqualNames(const char __far* farName, const char* nearName);
 
 #endif